@@ -2,9 +2,6 @@
 
 #include "Player.h"
 
-#include <vector>
-#include <random>
-
 namespace Labyrinth {
 	class DumbAI : public Player {
 	public:
@@ -12,8 +9,6 @@ namespace Labyrinth {
 
 	public:
 		// Inherited via AI
-		virtual Directions nextMove(Position current, std::vector<Cell> surroundings) override;
-
-		std::vector< std::vector<int> > memory;
+		virtual Directions nextMove(Position current, Surroundings surroundings, Random& random) override;
 	};
 }
@@ -0,0 +1,12 @@
+#include "GreedyAI.h"
+
+/**
+* Next move
+*
+*	Steps down the distance field, in constant time (none without a field or if cut from the end)
+*/
+Labyrinth::Directions Labyrinth::GreedyAI::nextMove(Position current, Surroundings surroundings, Random& /*random*/) {
+	if (m_distances == nullptr || m_distances->isEmpty())
+		return none;
+	return m_distances->towardsGoal(m_distances->index(current), surroundings);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Player.h"
+#include "../Pathfinding/DistanceField.h"
+
+namespace Labyrinth {
+	/**
+	* Greedy AI
+	*
+	*	Walks a shortest path to the end: always steps to the free neighbour the closest
+	*	to the goal, read from a distance field shared by every greedy player
+	*/
+	class GreedyAI : public Player {
+	public:
+		GreedyAI() : m_distances(nullptr) {};
+
+		// Inherited via AI
+		virtual Directions nextMove(Position current, Surroundings surroundings, Random& random) override;
+		virtual void reset() override { m_distances = nullptr; };
+		void setDistances(const DistanceField* distances) { m_distances = distances; };	/// The field to follow, owned by the simulation
+
+	protected:
+		const DistanceField* m_distances;
+	};
+}
@@ -1,12 +1,27 @@
-#include "pch.h"
 #include "Manual.h"
 
-Labyrinth::Directions Labyrinth::Manual::nextMove(Position current, std::vector<Cell> surroundings) {
+Labyrinth::Directions Labyrinth::Manual::nextMove(Position /*current*/, Surroundings /*surroundings*/, Random& /*random*/) {
 	Directions ret = m_next;
 	m_next = none;
 	return ret;
 }
 
+/**
+* Save state
+*
+*	The move waiting for the next turn
+*/
+void Labyrinth::Manual::saveState(std::vector<uint32_t>& words) const {
+	words.push_back((uint32_t)m_next);
+}
+
+bool Labyrinth::Manual::loadState(const uint32_t*& words, const uint32_t* end) {
+	if (end - words < 1 || *words > right)
+		return false;
+	m_next = (Directions)*words++;
+	return true;
+}
+
 void Labyrinth::Manual::moveDirection(Directions dir) {
 	m_next = dir;
 }
@@ -7,8 +7,13 @@ namespace Labyrinth {
 	class Manual : public Player {
 
 	public:
+		Manual() : m_next(none) {};
+
 		// Inherited via AI
-		virtual Directions nextMove(Position current, std::vector<Cell> surroundings) override;
+		virtual Directions nextMove(Position current, Surroundings surroundings, Random& random) override;
+		virtual void reset() override { m_next = none; };
+		virtual void saveState(std::vector<uint32_t>& words) const override;
+		virtual bool loadState(const uint32_t*& words, const uint32_t* end) override;
 		void moveDirection(Directions dir);
 
 	protected:
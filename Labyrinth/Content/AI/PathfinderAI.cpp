@@ -0,0 +1,172 @@
+#include "PathfinderAI.h"
+
+#include "../Pathfinding/AStar.h"
+
+Labyrinth::PathfinderAI::PathfinderAI() :
+	m_labyrinth(nullptr),
+	m_goal(0, 0),
+	m_hierarchy(nullptr),
+	m_landmarks(nullptr),
+	m_nextEntrance(0),
+	m_nextWaypoint(0),
+	m_planned(false),
+	m_expected(0, 0) {
+}
+
+void Labyrinth::PathfinderAI::reset() {
+	m_labyrinth = nullptr;
+	m_goal = Position(0, 0);
+	m_hierarchy = nullptr;
+	m_landmarks = nullptr;
+	m_entrances.clear();
+	m_nextEntrance = 0;
+	m_waypoints.clear();
+	m_nextWaypoint = 0;
+	m_planned = false;
+	m_expected = Position(0, 0);
+}
+
+void Labyrinth::PathfinderAI::setGoal(const Grid* labyrinth, Position goal, const HierarchicalGraph* hierarchy, const Landmarks* landmarks) {
+	m_labyrinth = labyrinth;
+	m_goal = goal;
+	m_hierarchy = hierarchy;
+	m_landmarks = landmarks;
+	m_planned = false;
+}
+
+/**
+* Plan
+*
+*	An unreachable goal leaves an empty plan: the player waits instead of searching every turn
+*/
+void Labyrinth::PathfinderAI::plan(Position from) {
+	m_waypoints.clear();
+	m_entrances.clear();
+	if (m_hierarchy != nullptr)
+		m_hierarchy->findPath(*m_labyrinth, from, m_goal, m_entrances, SearchArena::local());
+	else
+		AStar::findPath(*m_labyrinth, from, m_goal, m_waypoints, SearchArena::local(), true, m_landmarks);
+	m_nextEntrance = 0;
+	m_nextWaypoint = 0;
+	m_planned = true;
+	m_expected = from;
+}
+
+/**
+* Cell changed
+*
+*	A new wall is noticed when the plan runs into it. A removed wall can open a way to an
+*	unreachable goal: a player that has no plan plans again.
+*/
+void Labyrinth::PathfinderAI::cellChanged(Cell cell) {
+	if (cell != wall && m_waypoints.empty() && m_entrances.empty())
+		m_planned = false;
+}
+
+/**
+* Save state
+*
+*	planned, expected x and y, next entrance, entrance count, next waypoint, waypoint count,
+*	then the entrances and the waypoints (Grid indices, only valid in the same labyrinth)
+*/
+void Labyrinth::PathfinderAI::saveState(std::vector<uint32_t>& words) const {
+	uint32_t header[7] = { m_planned ? 1u : 0u, (uint32_t)m_expected.x, (uint32_t)m_expected.y,
+		(uint32_t)m_nextEntrance, (uint32_t)m_entrances.size(), (uint32_t)m_nextWaypoint, (uint32_t)m_waypoints.size() };
+	words.insert(words.end(), header, header + 7);
+	words.insert(words.end(), m_entrances.begin(), m_entrances.end());
+	words.insert(words.end(), m_waypoints.begin(), m_waypoints.end());
+}
+
+bool Labyrinth::PathfinderAI::loadState(const uint32_t*& words, const uint32_t* end) {
+	if (m_labyrinth == nullptr || end - words < 7)
+		return false;
+	size_t entrances(words[4]), waypoints(words[6]);
+	if ((size_t)(end - words - 7) < entrances + waypoints || words[3] > entrances || words[5] > waypoints)
+		return false;
+	for (size_t i(7); i < 7 + entrances + waypoints; ++i)
+		if (words[i] >= m_labyrinth->cellCount())
+			return false;
+	m_planned = words[0] != 0;
+	m_expected = Position((int)words[1], (int)words[2]);
+	m_nextEntrance = words[3];
+	m_nextWaypoint = words[5];
+	words += 7;
+	m_entrances.assign(words, words + entrances);
+	words += entrances;
+	m_waypoints.assign(words, words + waypoints);
+	words += waypoints;
+	return true;
+}
+
+/**
+* Refine
+*
+*	Two consecutive entrances are close (same tile or neighbour cells): a short search.
+*	False if the labyrinth changed and the next entrance cannot be reached anymore.
+*/
+bool Labyrinth::PathfinderAI::refine(Position from) {
+	size_t here(m_labyrinth->index(from));
+	while (m_nextEntrance < m_entrances.size() && m_entrances[m_nextEntrance] == here)
+		++m_nextEntrance;
+	m_waypoints.clear();
+	m_nextWaypoint = 0;
+	if (m_nextEntrance < m_entrances.size())
+		return AStar::findPath(*m_labyrinth, from, m_labyrinth->position(m_entrances[m_nextEntrance++]), m_waypoints, SearchArena::local());
+	return true;
+}
+
+/**
+* Step
+*
+*	One step towards the next waypoint, they all lie on a straight line from the previous one
+*/
+Labyrinth::Directions Labyrinth::PathfinderAI::step(Position current) {
+	size_t here(m_labyrinth->index(current));
+	if (m_nextWaypoint < m_waypoints.size() && m_waypoints[m_nextWaypoint] == here)
+		++m_nextWaypoint;
+	if (m_nextWaypoint == m_waypoints.size() && m_nextEntrance < m_entrances.size() && !refine(current)) {
+		plan(current);	// The hierarchy was updated since the plan was made
+		if (m_nextEntrance < m_entrances.size() && !refine(current))
+			m_entrances.clear();
+	}
+	if (m_nextWaypoint == m_waypoints.size())
+		return none;
+	Position target(m_labyrinth->position(m_waypoints[m_nextWaypoint]));
+	return target.y < current.y ? up : target.y > current.y ? down : target.x < current.x ? left : right;
+}
+
+/**
+* Next move
+*
+*	Follows the plan, made again when the player is not where it expects or faces a new wall
+*/
+Labyrinth::Directions Labyrinth::PathfinderAI::nextMove(Position current, Surroundings surroundings, Random& /*random*/) {
+	if (m_labyrinth == nullptr)
+		return none;
+	if (!m_planned || current != m_expected)
+		plan(current);
+
+	Directions dir(step(current));
+	if (dir != none && !surroundings.isOpen(dir)) {
+		plan(current);
+		dir = step(current);
+	}
+	m_expected = current;
+	switch (dir) {
+	case up:
+		--m_expected.y;
+		break;
+	case down:
+		++m_expected.y;
+		break;
+	case left:
+		--m_expected.x;
+		break;
+	case right:
+		++m_expected.x;
+		break;
+	default:
+		;
+	}
+	return dir;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Player.h"
+#include "../Maze/Grid.h"
+#include "../Pathfinding/HierarchicalGraph.h"
+#include "../Pathfinding/Landmarks.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Labyrinth {
+	/**
+	* Pathfinder AI
+	*
+	*	Plans a shortest path to the end with A* (jump points) and follows it step by step.
+	*	Plans again when it is not where its plan expects it (sent back to the origin, the
+	*	labyrinth reloaded). The searches run in the arena of the calling thread and the plan
+	*	keeps its capacity, so replanning does not allocate once warmed up.
+	*	Given a hierarchical graph, the plan is a list of tile entrances and only the way to the
+	*	next one is searched in the labyrinth, when it is reached.
+	*	Given landmarks, the plans made cell by cell use them as heuristic (ALT).
+	*	When the labyrinth is edited, a plan is only made again if its next step hits a new wall,
+	*	or if it was waiting for a goal it could not reach and a wall was removed.
+	*/
+	class PathfinderAI : public Player {
+	public:
+		PathfinderAI();
+
+		// Inherited via AI
+		virtual Directions nextMove(Position current, Surroundings surroundings, Random& random) override;
+		virtual void reset() override;	/// Drops the goal and the plan, the plan keeps its capacity
+		void setGoal(const Grid* labyrinth, Position goal, const HierarchicalGraph* hierarchy = nullptr, const Landmarks* landmarks = nullptr);	/// The labyrinth (owned by the simulation), the cell to reach, the graph to plan on and the landmarks of the labyrinth (optional), drops the plan
+		void cellChanged(Cell cell);	/// A cell of the labyrinth became cell
+		virtual void saveState(std::vector<uint32_t>& words) const override;	/// The plan and where it stands
+		virtual bool loadState(const uint32_t*& words, const uint32_t* end) override;	/// After setGoal on the same labyrinth
+
+	protected:
+		void plan(Position from);
+		bool refine(Position from);	/// Plan the moves to the next entrance
+		Directions step(Position current);	/// The next move of the plan, none when it is over
+
+		const Grid* m_labyrinth;
+		Position m_goal;
+		const HierarchicalGraph* m_hierarchy;
+		const Landmarks* m_landmarks;
+		std::vector<uint32_t> m_entrances;	/// With a hierarchy: the entrances to go through (Grid indices), the goal last
+		size_t m_nextEntrance;
+		std::vector<uint32_t> m_waypoints;	/// The cells where the plan turns (Grid indices), the goal (or the next entrance) last
+		size_t m_nextWaypoint;	/// The waypoint being walked to
+		bool m_planned;
+		Position m_expected;	/// Where the last move leads
+	};
+}
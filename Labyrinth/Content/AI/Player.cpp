@@ -1,3 +1,2 @@
-#include "pch.h"
 #include "Player.h"
 
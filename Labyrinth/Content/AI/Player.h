@@ -1,11 +1,18 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
+
 #include "../utils.h"
+#include "../Engine/Random.h"
 
 namespace Labyrinth {
 	class Player {
 	public:
-		virtual Directions nextMove(Position current, std::vector<Cell> surroundings) = 0;
+		virtual ~Player() {}
+		virtual Directions nextMove(Position current, Surroundings surroundings, Random& random) = 0;	/// random: the stream of the agent, owned by the simulation
+		virtual void reset() {}	/// Back to the state of a new player, keeping the memory it allocated (none by default)
+		virtual void saveState(std::vector<uint32_t>& /*words*/) const {}	/// Appends the internal state of the player to a checkpoint (none by default)
+		virtual bool loadState(const uint32_t*& /*words*/, const uint32_t* /*end*/) { return true; }	/// Reads back what saveState wrote and moves past it, false if it is cut short
 	};
 }
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Labyrinth {
+	/**
+	* Bits
+	*
+	*	Bit counting helpers for the 64-bit bitboards (compiler intrinsics).
+	*	MSVC only has the 64-bit intrinsics on x64: x86 and ARM work on the two 32-bit halves.
+	*/
+	namespace Bits {
+		inline int popCount(uint64_t bits) {	/// Number of set bits
+#if defined(_MSC_VER) && defined(_M_X64)
+			return (int)__popcnt64(bits);
+#elif defined(_MSC_VER) && defined(_M_IX86)
+			return (int)(__popcnt((unsigned int)bits) + __popcnt((unsigned int)(bits >> 32)));
+#elif defined(_MSC_VER)
+			// ARM: no population count on the integer registers, count in parallel (SWAR)
+			bits -= (bits >> 1) & 0x5555555555555555ull;
+			bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+			bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+			return (int)((bits * 0x0101010101010101ull) >> 56);
+#else
+			return __builtin_popcountll(bits);
+#endif
+		}
+
+		inline int lowest(uint64_t bits) {	/// Position of the lowest set bit, bits must not be 0
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long position;
+			_BitScanForward64(&position, bits);
+			return (int)position;
+#elif defined(_MSC_VER)
+			unsigned long position;
+			if (_BitScanForward(&position, (unsigned long)bits))
+				return (int)position;
+			_BitScanForward(&position, (unsigned long)(bits >> 32));
+			return (int)position + 32;
+#else
+			return __builtin_ctzll(bits);
+#endif
+		}
+
+		inline int highest(uint64_t bits) {	/// Position of the highest set bit, bits must not be 0
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long position;
+			_BitScanReverse64(&position, bits);
+			return (int)position;
+#elif defined(_MSC_VER)
+			unsigned long position;
+			if (_BitScanReverse(&position, (unsigned long)(bits >> 32)))
+				return (int)position + 32;
+			_BitScanReverse(&position, (unsigned long)bits);
+			return (int)position;
+#else
+			return 63 - __builtin_clzll(bits);
+#endif
+		}
+	}
+}
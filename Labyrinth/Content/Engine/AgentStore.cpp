@@ -0,0 +1,194 @@
+#include "AgentStore.h"
+
+#include <algorithm>
+
+using namespace Labyrinth;
+
+AgentStore::AgentStore() {
+}
+
+AgentStore::~AgentStore() {
+	// The pools own the Player objects
+}
+
+
+//	   ###    ########  ########
+//	  ## ##   ##     ## ##     ##
+//	 ##   ##  ##     ## ##     ##
+//	##     ## ##     ## ##     ##
+//	######### ##     ## ##     ##
+//	##     ## ##     ## ##     ##
+//	##     ## ########  ########
+
+AgentHandle AgentStore::add(AgentType type, Position at) {
+	size_t index(add(type, 1, at));
+	return handleAt(index);
+}
+
+/**
+* Add agents
+*
+*	Appends count agents at the end of every column
+*	type: the kind of player
+*	at: the starting position of the agents
+*/
+size_t AgentStore::add(AgentType type, size_t count, Position at) {
+	size_t first(size());
+	m_positions.resize(first + count, at);
+	m_directions.resize(first + count, none);
+	m_types.resize(first + count, type);
+	m_randoms.resize(first + count);
+	m_players.resize(first + count);
+	m_completions.resize(first + count, 0);
+	m_startTurns.resize(first + count, 0);
+	m_slotOfIndex.resize(first + count);
+
+	for (size_t index(first); index < first + count; ++index) {
+		m_players[index] = acquire(type);
+		m_slotOfIndex[index] = allocateSlot(index);
+	}
+	return first;
+}
+
+uint32_t AgentStore::allocateSlot(size_t index) {
+	uint32_t slot;
+	if (!m_freeSlots.empty()) {
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else {
+		slot = (uint32_t)m_indexOfSlot.size();
+		m_indexOfSlot.push_back(0);
+		m_generation.push_back(0);
+	}
+	m_indexOfSlot[slot] = (uint32_t)index;
+	return slot;
+}
+
+Player* AgentStore::acquire(AgentType type) {
+	switch (type) {
+	case manualAgent:
+		return m_manualPool.acquire();
+	case greedyAgent:
+		return m_greedyPool.acquire();
+	case pathfinderAgent:
+		return m_pathfinderPool.acquire();
+	default:
+		return m_dumbPool.acquire();
+	}
+}
+
+void AgentStore::release(AgentType type, Player* player) {
+	switch (type) {
+	case manualAgent:
+		m_manualPool.release((Manual*)player);
+		break;
+	case greedyAgent:
+		m_greedyPool.release((GreedyAI*)player);
+		break;
+	case pathfinderAgent:
+		m_pathfinderPool.release((PathfinderAI*)player);
+		break;
+	default:
+		m_dumbPool.release((DumbAI*)player);
+	}
+}
+
+
+//	########  ######## ##     ##  #######  ##     ## ########
+//	##     ## ##       ###   ### ##     ## ##     ## ##
+//	##     ## ##       #### #### ##     ## ##     ## ##
+//	########  ######   ## ### ## ##     ## ##     ## ######
+//	##   ##   ##       ##     ## ##     ##  ##   ##  ##
+//	##    ##  ##       ##     ## ##     ##   ## ##   ##
+//	##     ## ######## ##     ##  #######     ###    ########
+
+bool AgentStore::isValid(AgentHandle handle) const {
+	return handle.slot < m_generation.size() && m_generation[handle.slot] == handle.generation
+		&& m_indexOfSlot[handle.slot] < size() && m_slotOfIndex[m_indexOfSlot[handle.slot]] == handle.slot;
+}
+
+bool AgentStore::remove(AgentHandle handle) {
+	if (!isValid(handle))
+		return false;
+	removeAt(indexOf(handle));
+	return true;
+}
+
+void AgentStore::removeAt(size_t index) {
+	removeRange(index, 1);
+}
+
+/**
+* Remove a range of agents
+*
+*	The hole is filled with the last agents, so the cost is proportional to count
+*	first: the dense index of the first agent to remove
+*	count: the number of agents to remove
+*/
+void AgentStore::removeRange(size_t first, size_t count) {
+	if (first >= size())
+		return;
+	if (count > size() - first)
+		count = size() - first;
+
+	for (size_t index(first); index < first + count; ++index) {
+		release(m_types[index], m_players[index]);
+		uint32_t slot(m_slotOfIndex[index]);
+		++m_generation[slot];
+		m_freeSlots.push_back(slot);
+	}
+
+	// Move the agents after the hole (at most count of them) into it
+	size_t tail(size() - count);
+	if (tail < first + count)
+		tail = first + count;
+	for (size_t from(tail), to(first); from < size(); ++from, ++to)
+		moveAgent(from, to);
+
+	size_t newSize(size() - count);
+	m_positions.resize(newSize);
+	m_directions.resize(newSize);
+	m_types.resize(newSize);
+	m_randoms.resize(newSize);
+	m_players.resize(newSize);
+	m_completions.resize(newSize);
+	m_startTurns.resize(newSize);
+	m_slotOfIndex.resize(newSize);
+}
+
+void AgentStore::clear() {
+	removeRange(0, size());
+}
+
+/**
+* Restore
+*
+*	The Player objects are acquired one run of a type at a time, then each column is one copy
+*/
+void AgentStore::restore(size_t count, const AgentType* types, const Position* positions, const Directions* directions,
+	const Random* randoms, const uint32_t* completions, const int64_t* startTurns) {
+	clear();
+	for (size_t first(0), last(0); first < count; first = last) {
+		for (last = first + 1; last < count && types[last] == types[first]; ++last)
+			;
+		add(types[first], last - first, Position(0, 0));
+	}
+	std::copy(positions, positions + count, m_positions.begin());
+	std::copy(directions, directions + count, m_directions.begin());
+	std::copy(randoms, randoms + count, m_randoms.begin());
+	std::copy(completions, completions + count, m_completions.begin());
+	std::copy(startTurns, startTurns + count, m_startTurns.begin());
+}
+
+void AgentStore::moveAgent(size_t from, size_t to) {
+	m_positions[to] = m_positions[from];
+	m_directions[to] = m_directions[from];
+	m_types[to] = m_types[from];
+	m_randoms[to] = m_randoms[from];
+	m_players[to] = m_players[from];
+	m_completions[to] = m_completions[from];
+	m_startTurns[to] = m_startTurns[from];
+	m_slotOfIndex[to] = m_slotOfIndex[from];
+	m_indexOfSlot[m_slotOfIndex[to]] = (uint32_t)to;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../AI/Player.h"
+#include "../AI/DumbAI.h"
+#include "../AI/GreedyAI.h"
+#include "../AI/PathfinderAI.h"
+#include "../AI/Manual.h"
+#include "ObjectPool.h"
+#include "Random.h"
+
+namespace Labyrinth {
+	/**
+	* Agent type
+	*
+	*	The kind of Player behind an agent
+	*/
+	typedef enum AgentType_t : unsigned char {
+		manualAgent,
+		dumbAgent,
+		greedyAgent,
+		pathfinderAgent
+	} AgentType;
+
+	/**
+	* Agent handle
+	*
+	*	Stable reference to an agent: stays valid while the agent lives, whatever the removals
+	*/
+	class AgentHandle {
+	public:
+		AgentHandle(uint32_t slot = invalidSlot, uint32_t generation = 0) : slot(slot), generation(generation) {};
+		bool operator==(const AgentHandle& h) const { return (h.slot == slot) && (h.generation == generation); };
+
+		static const uint32_t invalidSlot = 0xFFFFFFFF;
+
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	/**
+	* Agent store
+	*
+	*	Structure of arrays holding every agent: position, scheduled direction, type,
+	*	random stream, Player object and completion counters are packed columns indexed by a dense index.
+	*	Removal moves the last agents into the hole (swap-remove), a slot map translates
+	*	stable handles into dense indices. Player objects come from per-type pools.
+	*/
+	class AgentStore {
+	public:
+		AgentStore();
+		~AgentStore();
+		AgentStore(const AgentStore&) = delete;
+		AgentStore& operator=(const AgentStore&) = delete;
+
+		size_t size() const { return m_positions.size(); }
+
+		AgentHandle add(AgentType type, Position at);	/// Add one agent
+		size_t add(AgentType type, size_t count, Position at);	/// Add count agents, returns the dense index of the first one
+		bool remove(AgentHandle handle);	/// Remove an agent by handle, false if it is not alive
+		void removeAt(size_t index);	/// Remove the agent at a dense index (the last agent takes its place)
+		void removeRange(size_t first, size_t count);	/// Remove count agents starting at a dense index
+		void clear();
+		void restore(size_t count, const AgentType* types, const Position* positions, const Directions* directions,
+			const Random* randoms, const uint32_t* completions, const int64_t* startTurns);	/// Replace every agent by count agents read from columns (new handles)
+
+		bool isValid(AgentHandle handle) const;
+		size_t indexOf(AgentHandle handle) const { return m_indexOfSlot[handle.slot]; }	/// Dense index of a valid handle
+		AgentHandle handleAt(size_t index) const { return AgentHandle(m_slotOfIndex[index], m_generation[m_slotOfIndex[index]]); }
+
+		// Packed columns, indexed by dense index
+		std::vector<Position>& positions() { return m_positions; }
+		const std::vector<Position>& positions() const { return m_positions; }
+		std::vector<Directions>& directions() { return m_directions; }
+		const std::vector<Directions>& directions() const { return m_directions; }
+		const std::vector<AgentType>& types() const { return m_types; }
+		std::vector<Random>& randoms() { return m_randoms; }
+		const std::vector<Random>& randoms() const { return m_randoms; }
+		const std::vector<Player*>& players() const { return m_players; }
+		std::vector<uint32_t>& completions() { return m_completions; }
+		const std::vector<uint32_t>& completions() const { return m_completions; }
+		std::vector<int64_t>& startTurns() { return m_startTurns; }
+		const std::vector<int64_t>& startTurns() const { return m_startTurns; }
+
+	private:
+		Player* acquire(AgentType type);
+		void release(AgentType type, Player* player);
+		uint32_t allocateSlot(size_t index);
+		void moveAgent(size_t from, size_t to);	/// Copy every column of an agent to another dense index
+
+		std::vector<Position> m_positions;	/// The coordinate of each agent
+		std::vector<Directions> m_directions;	/// The next turn's scheduled direction of each agent
+		std::vector<AgentType> m_types;
+		std::vector<Random> m_randoms;	/// The random stream of each agent
+		std::vector<Player*> m_players;	/// Pooled Player objects
+		std::vector<uint32_t> m_completions;	/// The number of times each agent reached the end
+		std::vector<int64_t> m_startTurns;	/// The turn each agent started its current way to the end (0 when added, set by the simulation)
+
+		// Slot map
+		std::vector<uint32_t> m_slotOfIndex;	/// Dense index -> slot
+		std::vector<uint32_t> m_indexOfSlot;	/// Slot -> dense index
+		std::vector<uint32_t> m_generation;	/// Slot -> generation, bumped when the slot is freed
+		std::vector<uint32_t> m_freeSlots;
+
+		ObjectPool<Manual> m_manualPool;
+		ObjectPool<DumbAI> m_dumbPool;
+		ObjectPool<GreedyAI> m_greedyPool;
+		ObjectPool<PathfinderAI> m_pathfinderPool;
+	};
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+namespace Labyrinth {
+	/**
+	* Cache line array
+	*
+	*	A fixed number of objects, each one alone on its own cache lines: written by different
+	*	threads, they never share a line. C++14 new ignores extended alignment (alignas), so the
+	*	storage is over-allocated and the first object placed on a line boundary by hand.
+	*/
+	template <typename T>
+	class CacheLineArray {
+	public:
+		static const size_t lineSize = 64;
+
+		CacheLineArray() : m_items(nullptr), m_count(0) {};
+		~CacheLineArray() { reset(0); };
+		CacheLineArray(const CacheLineArray&) = delete;
+		CacheLineArray& operator=(const CacheLineArray&) = delete;
+
+		/**
+		* Reset
+		*
+		*	Destroys the objects and makes count new ones (value-initialised)
+		*/
+		void reset(size_t count) {
+			for (size_t i(0); i < m_count; ++i)
+				m_items[i].~Slot();
+			m_items = nullptr;
+			m_count = 0;
+			m_storage.reset();
+			if (count == 0)
+				return;
+			m_storage.reset(new char[count * sizeof(Slot) + lineSize - 1]);
+			m_items = (Slot*)(((uintptr_t)m_storage.get() + lineSize - 1) & ~(uintptr_t)(lineSize - 1));
+			for (; m_count < count; ++m_count)
+				new (&m_items[m_count]) Slot();
+		};
+
+		size_t size() const { return m_count; }
+		T& operator[](size_t i) { return m_items[i].value; }
+		const T& operator[](size_t i) const { return m_items[i].value; }
+
+	private:
+		struct Slot {
+			Slot() : value() {};
+
+			T value;
+			char padding[lineSize - sizeof(T) % lineSize];
+		};
+
+		std::unique_ptr<char[]> m_storage;
+		Slot* m_items;	/// The first line boundary in m_storage
+		size_t m_count;
+	};
+}
@@ -0,0 +1,147 @@
+#include "Checkpoint.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+#include "../Maze/MazeFile.h"
+#include "AgentStore.h"
+#include "Random.h"
+
+using namespace Labyrinth;
+
+// The columns are copied to and from the image as raw bytes
+static_assert(sizeof(Position) == 8 && sizeof(Random) == 16 && sizeof(AgentType) == 1, "The checkpoint columns must keep their size");
+static_assert(std::is_trivially_copyable<Random>::value, "The random streams are saved as raw bytes");
+static_assert(sizeof(CheckpointHeader) % sizeof(uint64_t) == 0, "The header must be whole 64-bit words");
+
+namespace {
+	const char magicNumber[4] = { 'L', 'B', 'Y', 'C' };
+
+	uint64_t words(uint64_t bytes) {
+		return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+	}
+}
+
+Checkpoint::Checkpoint() :
+	m_size(0),
+	m_capacity(0) {
+}
+
+/**
+* Lay out
+*
+*	The sections are left as they were (the padding of their last word is cleared): the caller
+*	writes every one of them. The player states are copied from stateWords.
+*/
+void Checkpoint::layOut(const CheckpointHeader& counts) {
+	CheckpointHeader header(counts);
+	memcpy(header.magic, magicNumber, sizeof(magicNumber));
+	header.version = version;
+	header.headerSize = sizeof(CheckpointHeader);
+	header.directionSize = sizeof(Directions);
+	header.stateWords = m_states.size();
+	header.reserved = 0;
+	header.checksum = 0;
+	header.padding = 0;
+	header.fileSize = sectionOffset(header, checkpointSectionCount);
+
+	m_size = (size_t)(header.fileSize / sizeof(uint64_t));
+	if (m_size > m_capacity) {
+		m_image.reset(new uint64_t[m_size]);
+		m_capacity = m_size;
+	}
+	memcpy(m_image.get(), &header, sizeof(header));
+	for (int s(0); s < checkpointSectionCount; ++s) {
+		uint64_t bytes(sectionBytes(header, (CheckpointSection)s));
+		if (bytes % sizeof(uint64_t) != 0)
+			m_image[(size_t)((sectionOffset(header, (CheckpointSection)s) + bytes) / sizeof(uint64_t))] = 0;
+	}
+	if (!m_states.empty())
+		memcpy(section(stateSection), m_states.data(), m_states.size() * sizeof(uint32_t));
+}
+
+uint64_t Checkpoint::sectionBytes(const CheckpointHeader& header, CheckpointSection section) {
+	switch (section) {
+	case wallSection:
+		return header.wallWords * sizeof(uint64_t);
+	case positionSection:
+		return header.agentCount * sizeof(Position);
+	case randomSection:
+		return header.agentCount * sizeof(Random);
+	case startTurnSection:
+		return header.agentCount * sizeof(int64_t);
+	case completionSection:
+		return header.agentCount * sizeof(uint32_t);
+	case directionSection:
+		return header.agentCount * sizeof(Directions);
+	case typeSection:
+		return header.agentCount * sizeof(AgentType);
+	case stateSection:
+		return header.stateWords * sizeof(uint32_t);
+	default:
+		return 0;
+	}
+}
+
+/**
+* Section offset
+*
+*	checkpointSectionCount gives the size of the file
+*/
+uint64_t Checkpoint::sectionOffset(const CheckpointHeader& header, CheckpointSection section) {
+	uint64_t offset(sizeof(CheckpointHeader));
+	for (int s(0); s < section; ++s)
+		offset += words(sectionBytes(header, (CheckpointSection)s)) * sizeof(uint64_t);
+	return offset;
+}
+
+/**
+* Save
+*
+*	Writes the image with its checksum. Does not touch the simulation: it can run on any thread.
+*/
+bool Checkpoint::save(const std::string& filename) const {
+	if (isEmpty())
+		return false;
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	const size_t headerWords(sizeof(CheckpointHeader) / sizeof(uint64_t));
+	CheckpointHeader header(this->header());
+	header.checksum = MazeFile::checksum(m_image.get() + headerWords, m_size - headerWords);
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)(m_image.get() + headerWords), (std::streamsize)((m_size - headerWords) * sizeof(uint64_t)));
+	return out.good();
+}
+
+/**
+* Validate
+*
+*	Checks the header, the sizes and the checksum. data must be aligned on 64-bit words (a mapping is).
+*/
+bool Checkpoint::validate(const char* data, uint64_t size) {
+	if (data == nullptr || size < sizeof(CheckpointHeader) || size % sizeof(uint64_t) != 0 || memcmp(data, magicNumber, sizeof(magicNumber)) != 0)
+		return false;
+	CheckpointHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.version != version || header.headerSize != sizeof(CheckpointHeader) || header.directionSize != sizeof(Directions))
+		return false;
+	if (header.sizeX <= 0 || header.sizeY <= 0)
+		return false;
+	if (header.originX < 0 || header.originX >= header.sizeX || header.originY < 0 || header.originY >= header.sizeY
+		|| header.endX < 0 || header.endX >= header.sizeX || header.endY < 0 || header.endY >= header.sizeY)
+		return false;
+	if (header.wallWords != ((uint64_t)header.sizeX + 65) / 64 * ((uint64_t)header.sizeY + 2))
+		return false;
+
+	// Bounded by the size first, the offsets cannot wrap
+	if (header.agentCount == 0 || header.agentCount > size / sizeof(uint64_t) || header.stateWords > size / sizeof(uint32_t) || header.wallWords > size / sizeof(uint64_t))
+		return false;
+	if (header.fileSize != size || sectionOffset(header, checkpointSectionCount) != size)
+		return false;
+
+	const size_t headerWords(sizeof(CheckpointHeader) / sizeof(uint64_t));
+	return MazeFile::checksum((const uint64_t*)data + headerWords, (size_t)(size / sizeof(uint64_t)) - headerWords) == header.checksum;
+}
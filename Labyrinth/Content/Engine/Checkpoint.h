@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+
+namespace Labyrinth {
+	/**
+	* Checkpoint header
+	*
+	*	128 bytes at the start of a checkpoint file, followed by the sections in the order of
+	*	CheckpointSection, each one starting on a 64-bit word. The offsets only depend on the
+	*	counts of the header (Checkpoint::sectionOffset). All fields are little-endian.
+	*/
+	struct CheckpointHeader {
+		char magic[4];	/// "LBYC"
+		uint32_t version;	/// Checkpoint::version
+		uint32_t headerSize;	/// sizeof(CheckpointHeader), offset of the first section
+		uint32_t directionSize;	/// sizeof(Directions), the enum is saved as it is in memory
+		int32_t sizeX;	/// The width in cells of the labyrinth
+		int32_t sizeY;	/// The height in cells of the labyrinth
+		int32_t originX;
+		int32_t originY;
+		int32_t endX;
+		int32_t endY;
+		uint32_t batchExecution;
+		uint32_t reserved;
+		uint64_t seed;
+		uint64_t spawnCount;
+		int64_t turnCount;
+		uint64_t landmarkCount;
+		uint64_t agentCount;
+		uint64_t wallWords;	/// Words in the wall plane: wallStride * (sizeY + 2), like MazeFileHeader
+		uint64_t stateWords;	/// 32-bit words of player state, every player one after the other
+		uint64_t fileSize;
+		uint64_t checksum;	/// MazeFile::checksum of everything after the header
+		uint64_t padding;
+	};
+	static_assert(sizeof(CheckpointHeader) == 128, "The checkpoint header must stay 128 bytes");
+
+	/**
+	* Checkpoint section
+	*/
+	typedef enum CheckpointSection_t {
+		wallSection,	/// The wall plane of the grid, used in place once mapped
+		positionSection,
+		randomSection,	/// The random streams of the agents
+		startTurnSection,
+		completionSection,
+		directionSection,
+		typeSection,
+		stateSection,	/// What Player::saveState wrote, in agent order
+		checkpointSectionCount
+	} CheckpointSection;
+
+	/**
+	* Checkpoint
+	*
+	*	The whole state of a simulation in one flat image, laid out exactly like the file:
+	*	the labyrinth, the columns of the agents, their internal states, the seed and the turn.
+	*	The simulation fills it between two turns with one copy per column; it is then a plain
+	*	buffer the simulation does not touch again, so it can be saved from another thread while
+	*	the turns go on. The image keeps its capacity from one checkpoint to the next.
+	*	A saved checkpoint is read back by mapping the file: the walls are used where they lie
+	*	and each column is one copy, nothing is parsed field by field.
+	*/
+	class Checkpoint {
+	public:
+		static const uint32_t version = 1;
+
+		Checkpoint();
+
+		void layOut(const CheckpointHeader& counts);	/// Sizes the image for the counts of a header and writes the header (magic, version and sizes filled in)
+		std::vector<uint32_t>& stateWords() { return m_states; }	/// The player states, gathered before layOut
+
+		bool isEmpty() const { return m_size == 0; }
+		const CheckpointHeader& header() const { return *(const CheckpointHeader*)m_image.get(); }
+		void* section(CheckpointSection section) { return (char*)m_image.get() + sectionOffset(header(), section); }
+		const void* section(CheckpointSection section) const { return (const char*)m_image.get() + sectionOffset(header(), section); }
+		size_t memoryBytes() const { return m_size * sizeof(uint64_t); }	/// Size of the image (in memory and on disk)
+
+		bool save(const std::string& filename) const;	/// Checksums the image on the way, only reads it
+
+		static uint64_t sectionOffset(const CheckpointHeader& header, CheckpointSection section);	/// Byte offset of a section from the start of the file
+		static uint64_t sectionBytes(const CheckpointHeader& header, CheckpointSection section);
+		static bool validate(const char* data, uint64_t size);	/// A whole checkpoint of this version, checksum included
+
+	private:
+		std::unique_ptr<uint64_t[]> m_image;	/// Header then sections, whole words. Not cleared: every byte is written by the capture
+		size_t m_size;	/// Words used in m_image
+		size_t m_capacity;
+		std::vector<uint32_t> m_states;
+	};
+}
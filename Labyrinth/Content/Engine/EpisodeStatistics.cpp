@@ -0,0 +1,103 @@
+#include "EpisodeStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../Bits.h"
+
+using namespace Labyrinth;
+
+const uint32_t EpisodeStatistics::exactValues;
+
+EpisodeStatistics::EpisodeStatistics() :
+	m_count(0),
+	m_unfinished(0),
+	m_sum(0),
+	m_squaresLow(0),
+	m_squaresHigh(0),
+	m_minimum(0xFFFFFFFF),
+	m_maximum(0),
+	m_histogram(bucket(0xFFFFFFFF) + 1, 0) {
+}
+
+void EpisodeStatistics::add(uint32_t turns) {
+	++m_count;
+	m_sum += turns;
+	uint64_t square((uint64_t)turns * turns);
+	m_squaresLow += square;
+	m_squaresHigh += m_squaresLow < square;	// Carry
+	m_minimum = std::min(m_minimum, turns);
+	m_maximum = std::max(m_maximum, turns);
+	++m_histogram[bucket(turns)];
+}
+
+void EpisodeStatistics::merge(const EpisodeStatistics& other) {
+	m_count += other.m_count;
+	m_unfinished += other.m_unfinished;
+	m_sum += other.m_sum;
+	m_squaresLow += other.m_squaresLow;
+	m_squaresHigh += other.m_squaresHigh + (m_squaresLow < other.m_squaresLow);
+	m_minimum = std::min(m_minimum, other.m_minimum);
+	m_maximum = std::max(m_maximum, other.m_maximum);
+	for (size_t i(0); i < m_histogram.size(); ++i)
+		m_histogram[i] += other.m_histogram[i];
+}
+
+void EpisodeStatistics::clear() {
+	m_count = 0;
+	m_unfinished = 0;
+	m_sum = 0;
+	m_squaresLow = 0;
+	m_squaresHigh = 0;
+	m_minimum = 0xFFFFFFFF;
+	m_maximum = 0;
+	std::fill(m_histogram.begin(), m_histogram.end(), 0);
+}
+
+double EpisodeStatistics::mean() const {
+	return m_count > 0 ? (double)m_sum / (double)m_count : 0.0;
+}
+
+double EpisodeStatistics::variance() const {
+	if (m_count < 2)
+		return 0.0;
+	double squares((double)m_squaresHigh * 18446744073709551616.0 + (double)m_squaresLow);
+	return std::max(0.0, (squares - (double)m_sum * mean()) / (double)(m_count - 1));
+}
+
+double EpisodeStatistics::standardDeviation() const {
+	return std::sqrt(variance());
+}
+
+/**
+* Percentile
+*
+*	The middle of the bucket holding the episode of that rank, within the extremes
+*/
+uint32_t EpisodeStatistics::percentile(double fraction) const {
+	if (m_count == 0)
+		return 0;
+	uint64_t rank((uint64_t)std::ceil(std::min(std::max(fraction, 0.0), 1.0) * (double)m_count));
+	rank = std::max(rank, (uint64_t)1);
+	uint64_t seen(0);
+	size_t i(0);
+	while (seen + m_histogram[i] < rank)
+		seen += m_histogram[i++];
+	uint64_t middle(((uint64_t)bucketStart(i) + (i + 1 < m_histogram.size() ? bucketStart(i + 1) : 0x100000000ull) - 1) / 2);
+	return (uint32_t)std::min(std::max(middle, (uint64_t)m_minimum), (uint64_t)m_maximum);
+}
+
+size_t EpisodeStatistics::bucket(uint32_t turns) {
+	if (turns < exactValues)
+		return turns;
+	int high(Bits::highest(turns));	// 6 or more
+	return exactValues + ((size_t)(high - 6) << subBucketBits) + ((turns >> (high - subBucketBits)) & ((1u << subBucketBits) - 1));
+}
+
+uint32_t EpisodeStatistics::bucketStart(size_t bucket) {
+	if (bucket < exactValues)
+		return (uint32_t)bucket;
+	size_t high(6 + ((bucket - exactValues) >> subBucketBits));
+	uint32_t sub((uint32_t)((bucket - exactValues) & ((1u << subBucketBits) - 1)));
+	return ((1u << subBucketBits) + sub) << (high - subBucketBits);
+}
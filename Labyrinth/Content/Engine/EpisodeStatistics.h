@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Labyrinth {
+	/**
+	* Episode statistics
+	*
+	*	Streaming summary of the turns taken by many episodes to reach the end, without keeping
+	*	the episodes: count, sums, extremes and a log histogram for the percentiles.
+	*	The values below 64 have a bucket each, then every power of two is cut in 32 buckets,
+	*	so a percentile is off by at most 1/32 of its value.
+	*	Everything is an integer (the sum of squares on 128 bits): merging the statistics of
+	*	several workers gives the same result in any order.
+	*/
+	class EpisodeStatistics {
+	public:
+		EpisodeStatistics();
+
+		void add(uint32_t turns);	/// An episode that reached the end after turns turns
+		void addUnfinished() { ++m_unfinished; }	/// An episode stopped before reaching the end
+		void merge(const EpisodeStatistics& other);
+		void clear();
+
+		uint64_t count() const { return m_count; }	/// Episodes that reached the end
+		uint64_t unfinished() const { return m_unfinished; }
+		double mean() const;
+		double variance() const;	/// Sample variance (0 under 2 episodes)
+		double standardDeviation() const;
+		uint32_t minimum() const { return m_count > 0 ? m_minimum : 0; }
+		uint32_t maximum() const { return m_maximum; }
+		uint32_t percentile(double fraction) const;	/// The turns under which a fraction (0 to 1) of the finished episodes ended
+
+	private:
+		static const uint32_t exactValues = 64;
+		static const int subBucketBits = 5;
+		static size_t bucket(uint32_t turns);
+		static uint32_t bucketStart(size_t bucket);
+
+		uint64_t m_count;
+		uint64_t m_unfinished;
+		uint64_t m_sum;
+		uint64_t m_squaresLow;	/// Sum of the squares, low 64 bits
+		uint64_t m_squaresHigh;	/// Sum of the squares, high 64 bits
+		uint32_t m_minimum;
+		uint32_t m_maximum;
+		std::vector<uint64_t> m_histogram;	/// Episodes per bucket
+	};
+}
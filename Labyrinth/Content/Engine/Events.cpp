@@ -0,0 +1,37 @@
+#include "Events.h"
+
+using namespace Labyrinth;
+
+EventBuffers::EventBuffers(const ThreadPool* threadPool) :
+	m_threadPool(nullptr) {
+	setThreadPool(threadPool);
+}
+
+void EventBuffers::setThreadPool(const ThreadPool* threadPool) {
+	m_threadPool = threadPool;
+	m_buffers.reset(threadPool != nullptr ? threadPool->getWorkerCount() : 1);
+}
+
+void EventBuffers::push(const Event& event) {
+	m_buffers[ThreadPool::currentWorker(m_threadPool)].push_back(event);
+}
+
+/**
+* Drain
+*
+*	The buffers keep their capacity: a steady flow of events does not allocate
+*/
+void EventBuffers::drain(std::vector<Event>& events) {
+	for (size_t worker(0); worker < m_buffers.size(); ++worker) {
+		std::vector<Event>& buffer = m_buffers[worker];
+		events.insert(events.end(), buffer.begin(), buffer.end());
+		buffer.clear();
+	}
+}
+
+bool EventBuffers::isEmpty() const {
+	for (size_t worker(0); worker < m_buffers.size(); ++worker)
+		if (!m_buffers[worker].empty())
+			return false;
+	return true;
+}
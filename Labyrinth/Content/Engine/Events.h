@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "CacheLineArray.h"
+#include "EpisodeStatistics.h"
+#include "ThreadPool.h"
+
+namespace Labyrinth {
+	/**
+	* Event type
+	*
+	*	What happened to an agent during a turn
+	*/
+	typedef enum EventType_t : unsigned char {
+		endReached,	/// The agent stepped on the end and went back to the origin
+		blockedMove,	/// The agent tried to move into a wall or out of the labyrinth
+		spawn	/// The agent was added at the origin
+	} EventType;
+
+	/**
+	* Event
+	*/
+	struct Event {
+		Event(EventType type = spawn, uint32_t agent = 0, Position at = Position(0, 0)) : agent(agent), at(at), type(type) {};
+
+		uint32_t agent;	/// Dense index of the agent when the event happened
+		Position at;	/// The end, the cell the agent ran into or where it appeared
+		EventType type;
+	};
+
+	/**
+	* Event counters
+	*
+	*	Totals over every drained event
+	*/
+	struct EventCounters {
+		EventCounters() : endReached(0), blockedMoves(0), spawns(0) {};
+
+		uint64_t endReached;
+		uint64_t blockedMoves;
+		uint64_t spawns;
+		EpisodeStatistics turnsPerCompletion;	/// Turns from the start (spawn, load or last completion) of an agent to the end
+		EpisodeStatistics completionsPerTurn;	/// Throughput: agents reaching the end in each turn
+	};
+
+	/**
+	* Event buffers
+	*
+	*	One event buffer per worker of a thread pool: a worker only appends to its own buffer
+	*	(ThreadPool::currentWorker of that pool), so pushing takes no lock nor atomic. Any other
+	*	thread pushes to the buffer of worker 0, the thread driving the pool. The buffers are
+	*	drained by one thread between the parallel phases, worker by worker: the order of the
+	*	events of one turn depends on the scheduling, not their number.
+	*/
+	class EventBuffers {
+	public:
+		EventBuffers(const ThreadPool* threadPool = nullptr);
+		EventBuffers(const EventBuffers&) = delete;
+		EventBuffers& operator=(const EventBuffers&) = delete;
+
+		void setThreadPool(const ThreadPool* threadPool);	/// One buffer per worker of threadPool (nullptr: one buffer), drops the pending events
+		void push(const Event& event);	/// From a worker of the pool, or from the thread driving it
+		void drain(std::vector<Event>& events);	/// Appends every pending event to events and empties the buffers
+		bool isEmpty() const;
+
+	private:
+		const ThreadPool* m_threadPool;
+		CacheLineArray<std::vector<Event>> m_buffers;	/// One per worker, on their own cache lines
+	};
+}
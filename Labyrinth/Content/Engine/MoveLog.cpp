@@ -0,0 +1,271 @@
+#include "MoveLog.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "../Maze/MazeFile.h"
+
+using namespace Labyrinth;
+
+// The keyframes and the positions are checksummed and saved as raw 64-bit words
+static_assert(sizeof(Position) == sizeof(uint64_t), "Position must be two packed ints");
+static_assert(sizeof(MoveLogKeyframe) % sizeof(uint64_t) == 0, "The keyframes must be whole 64-bit words");
+
+namespace {
+	const char magicNumber[4] = { 'L', 'B', 'Y', 'M' };
+	const int deltaX[5] = { 0, 0, 0, -1, 1 };	/// Column offset of each move
+	const int deltaY[5] = { 0, -1, 1, 0, 0 };	/// Row offset of each move
+	const unsigned noMove = 8;	/// Not a move: the positions need a keyframe
+	const unsigned stepCodes[3][3] = {	/// The move of a step, by [dy + 1][dx + 1]
+		{ noMove, up, noMove },
+		{ left, none, right },
+		{ noMove, down, noMove }
+	};
+
+	/**
+	* Packed position
+	*
+	*	A Position as one 64-bit word (x in the low half): a move adds one of packedDeltas.
+	*	Moving left borrows from the high half and gives it back, x stays at least 0 in a labyrinth.
+	*/
+	inline uint64_t pack(Position p) {
+		return (uint64_t)(uint32_t)p.y << 32 | (uint32_t)p.x;
+	}
+	inline Position unpack(uint64_t packed) {
+		return Position((int)(uint32_t)packed, (int)(uint32_t)(packed >> 32));
+	}
+	const uint64_t packedDeltas[8] = { 0, (uint64_t)-(int64_t)0x100000000ll, 0x100000000ull, (uint64_t)-1ll, 1, 0, 0, 0 };
+}
+
+MoveLog::MoveLog(int64_t keyframeInterval) :
+	m_keyframeInterval(keyframeInterval > 0 ? keyframeInterval : 1),
+	m_lastTurn(0),
+	m_moveCount(0) {
+}
+
+void MoveLog::clear() {
+	m_lastTurn = 0;
+	m_moveCount = 0;
+	m_keyframes.clear();
+	m_keyPositions.clear();
+	m_words.clear();
+	m_previous.clear();
+}
+
+/**
+* Record
+*
+*	A turn that does not follow the last one starts a new log
+*	turn: the turn just played
+*	positions: the positions of the players after it
+*/
+void MoveLog::record(int64_t turn, const std::vector<Position>& positions, Position origin, Position end) {
+	if (!m_keyframes.empty() && turn <= m_lastTurn)
+		clear();
+	if (!m_keyframes.empty() && turn == m_lastTurn + 1 && positions.size() == m_previous.size()) {
+		const MoveLogKeyframe& keyframe = m_keyframes.back();
+		if (turn - keyframe.turn < m_keyframeInterval
+			&& origin == Position(keyframe.originX, keyframe.originY) && end == Position(keyframe.endX, keyframe.endY)) {
+			size_t first(m_words.size());
+			m_words.resize(first + wordsPerTurn(positions.size()));
+			if (encode(m_previous.data(), positions.data(), positions.size(), origin, end, m_words.data() + first)) {
+				m_lastTurn = turn;
+				m_moveCount += positions.size();
+				return;
+			}
+			m_words.resize(first);
+		}
+	}
+	addKeyframe(turn, positions, origin, end);
+}
+
+void MoveLog::addKeyframe(int64_t turn, const std::vector<Position>& positions, Position origin, Position end) {
+	MoveLogKeyframe keyframe;
+	keyframe.turn = turn;
+	keyframe.firstPosition = m_keyPositions.size();
+	keyframe.count = positions.size();
+	keyframe.firstWord = m_words.size();
+	keyframe.originX = origin.x;
+	keyframe.originY = origin.y;
+	keyframe.endX = end.x;
+	keyframe.endY = end.y;
+	m_keyframes.push_back(keyframe);
+	m_keyPositions.insert(m_keyPositions.end(), positions.begin(), positions.end());
+	m_previous.assign(positions.begin(), positions.end());
+	m_lastTurn = turn;
+}
+
+/**
+* Encode
+*
+*	A move is a step to a neighbour, or a step on the end and back to the origin.
+*	Standing on the end is not a move: the replay would send the player back to the origin.
+*	No early exit, the positions are all read anyway: previous is only valid on success.
+*/
+bool MoveLog::encode(Position* previous, const Position* current, size_t count, Position origin, Position end, uint64_t* words) {
+	uint64_t stray(end == origin ? ~0ull : pack(end));	/// The cell a step cannot end on
+	unsigned invalid(0);
+	for (size_t word(0), i(0); i < count; ++word) {
+		uint64_t moves(0);
+		size_t last(std::min(count, i + movesPerWord));
+		for (int shift(0); i < last; ++i, shift += 3) {
+			Position from(previous[i]), to(current[i]);
+			unsigned column((unsigned)(to.x - from.x + 1)), row((unsigned)(to.y - from.y + 1));
+			unsigned code(column < 3 && row < 3 && pack(to) != stray ? stepCodes[row][column] : noMove);
+			if (code == noMove && to == origin)
+				for (unsigned dir(up); dir <= right; ++dir)
+					if (Position(from.x + deltaX[dir], from.y + deltaY[dir]) == end)
+						code = dir;
+			invalid |= code & noMove;
+			moves |= (uint64_t)code << shift;
+			previous[i] = to;
+		}
+		words[word] = moves;
+	}
+	return invalid == 0;
+}
+
+/**
+* Seek
+*
+*	From the last keyframe at or before the turn, at most keyframeInterval turns of moves
+*/
+bool MoveLog::seek(int64_t turn, ReplayState& state) const {
+	if (m_keyframes.empty() || turn < m_keyframes.front().turn || turn > m_lastTurn)
+		return false;
+	auto after = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), turn,
+		[](int64_t t, const MoveLogKeyframe& keyframe) { return t < keyframe.turn; });
+	size_t index((size_t)(after - m_keyframes.begin()) - 1);
+	const MoveLogKeyframe& keyframe = m_keyframes[index];
+	state.turn = keyframe.turn;
+	state.keyframe = index;
+	state.origin = Position(keyframe.originX, keyframe.originY);
+	state.end = Position(keyframe.endX, keyframe.endY);
+	state.positions.assign(m_keyPositions.begin() + (ptrdiff_t)keyframe.firstPosition,
+		m_keyPositions.begin() + (ptrdiff_t)(keyframe.firstPosition + keyframe.count));
+	return advance(state, turn - keyframe.turn);
+}
+
+/**
+* Advance
+*
+*	One pass over the moves of each turn, 21 players per word read
+*/
+bool MoveLog::advance(ReplayState& state, int64_t turns) const {
+	for (int64_t turn(0); turn < turns; ++turn) {
+		int64_t next(state.turn + 1);
+		if (m_keyframes.empty() || next > m_lastTurn)
+			return false;
+		if (state.keyframe + 1 < m_keyframes.size() && m_keyframes[state.keyframe + 1].turn == next) {
+			if (!seek(next, state))
+				return false;
+			continue;
+		}
+
+		const MoveLogKeyframe& keyframe = m_keyframes[state.keyframe];
+		size_t count((size_t)keyframe.count);
+		const uint64_t* words = m_words.data() + keyframe.firstWord + (size_t)(next - keyframe.turn - 1) * wordsPerTurn(count);
+		Position* positions = state.positions.data();
+		uint64_t origin(pack(state.origin)), end(pack(state.end));
+		for (size_t i(0); i < count; ++words) {
+			uint64_t moves(*words);
+			size_t last(std::min(count, i + movesPerWord));
+			for (; i < last; ++i, moves >>= 3) {
+				uint64_t position(pack(positions[i]) + packedDeltas[moves & 7]);
+				positions[i] = unpack(position == end ? origin : position);
+			}
+		}
+		state.turn = next;
+	}
+	return true;
+}
+
+size_t MoveLog::memoryBytes() const {
+	return sizeof(MoveLogHeader) + m_keyframes.size() * sizeof(MoveLogKeyframe) + m_keyPositions.size() * sizeof(Position) + m_words.size() * sizeof(uint64_t);
+}
+
+uint64_t MoveLog::checksum() const {
+	uint64_t hash(MazeFile::checksum((const uint64_t*)m_keyframes.data(), m_keyframes.size() * sizeof(MoveLogKeyframe) / sizeof(uint64_t)));
+	hash = MazeFile::checksum((const uint64_t*)m_keyPositions.data(), m_keyPositions.size(), hash);
+	return MazeFile::checksum(m_words.data(), m_words.size(), hash);
+}
+
+/**
+* Save
+*
+*	Writes the header followed by the keyframes, their positions and the moves
+*/
+bool MoveLog::save(const std::string& filename) const {
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	MoveLogHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magicNumber, sizeof(magicNumber));
+	header.version = version;
+	header.headerSize = sizeof(MoveLogHeader);
+	header.keyframeSize = sizeof(MoveLogKeyframe);
+	header.keyframeInterval = m_keyframeInterval;
+	header.lastTurn = m_lastTurn;
+	header.keyframeCount = m_keyframes.size();
+	header.positionCount = m_keyPositions.size();
+	header.wordCount = m_words.size();
+	header.checksum = checksum();
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)m_keyframes.data(), (std::streamsize)(m_keyframes.size() * sizeof(MoveLogKeyframe)));
+	out.write((const char*)m_keyPositions.data(), (std::streamsize)(m_keyPositions.size() * sizeof(Position)));
+	out.write((const char*)m_words.data(), (std::streamsize)(m_words.size() * sizeof(uint64_t)));
+	return out.good();
+}
+
+/**
+* Load
+*
+*	Checks the header, the sizes and the checksum. Recording can go on after the last turn.
+*/
+bool MoveLog::load(const std::string& filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (!in.is_open())
+		return false;
+
+	MoveLogHeader header;
+	if (!in.read((char*)&header, sizeof(header)) || memcmp(header.magic, magicNumber, sizeof(magicNumber)) != 0)
+		return false;
+	if (header.version != version || header.headerSize != sizeof(MoveLogHeader) || header.keyframeSize != sizeof(MoveLogKeyframe))
+		return false;
+	in.seekg(0, std::ios::end);
+	uint64_t size((uint64_t)in.tellg());
+	if (size != header.headerSize + header.keyframeCount * sizeof(MoveLogKeyframe) + (header.positionCount + header.wordCount) * sizeof(uint64_t))
+		return false;
+	in.seekg(header.headerSize);
+
+	MoveLog log(header.keyframeInterval);
+	log.m_lastTurn = header.lastTurn;
+	log.m_keyframes.resize((size_t)header.keyframeCount);
+	log.m_keyPositions.resize((size_t)header.positionCount);
+	log.m_words.resize((size_t)header.wordCount);
+	in.read((char*)log.m_keyframes.data(), (std::streamsize)(log.m_keyframes.size() * sizeof(MoveLogKeyframe)));
+	in.read((char*)log.m_keyPositions.data(), (std::streamsize)(log.m_keyPositions.size() * sizeof(Position)));
+	in.read((char*)log.m_words.data(), (std::streamsize)(log.m_words.size() * sizeof(uint64_t)));
+	if (!in || log.checksum() != header.checksum)
+		return false;
+
+	// Each keyframe must fit in the positions, and its moves in the words
+	for (size_t k(0); k < log.m_keyframes.size(); ++k) {
+		const MoveLogKeyframe& keyframe = log.m_keyframes[k];
+		int64_t nextTurn(k + 1 < log.m_keyframes.size() ? log.m_keyframes[k + 1].turn : log.m_lastTurn + 1);
+		uint64_t nextWord(k + 1 < log.m_keyframes.size() ? log.m_keyframes[k + 1].firstWord : header.wordCount);
+		if (nextTurn <= keyframe.turn || keyframe.firstPosition + keyframe.count > header.positionCount
+			|| keyframe.firstWord + (uint64_t)(nextTurn - keyframe.turn - 1) * wordsPerTurn((size_t)keyframe.count) != nextWord)
+			return false;
+		log.m_moveCount += (uint64_t)(nextTurn - keyframe.turn - 1) * keyframe.count;
+	}
+
+	ReplayState last;
+	if (!log.isEmpty() && log.seek(log.m_lastTurn, last))
+		log.m_previous.swap(last.positions);
+	*this = std::move(log);
+	return true;
+}
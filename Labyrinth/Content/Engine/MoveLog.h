@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+
+namespace Labyrinth {
+	/**
+	* Move log header
+	*
+	*	64 bytes at the start of a move log file, followed by the keyframes, the keyframe
+	*	positions and the move words, each laid out exactly like in memory. All fields are little-endian.
+	*/
+	struct MoveLogHeader {
+		char magic[4];	/// "LBYM"
+		uint32_t version;	/// MoveLog::version
+		uint32_t headerSize;	/// sizeof(MoveLogHeader), offset of the keyframes
+		uint32_t keyframeSize;	/// sizeof(MoveLogKeyframe)
+		int64_t keyframeInterval;
+		int64_t lastTurn;
+		uint64_t keyframeCount;
+		uint64_t positionCount;
+		uint64_t wordCount;
+		uint64_t checksum;	/// MazeFile::checksum of the keyframes, the positions and the words
+	};
+	static_assert(sizeof(MoveLogHeader) == 64, "The move log header must stay 64 bytes");
+
+	/**
+	* Move log keyframe
+	*
+	*	The positions of every player after a turn, and where the moves of the following turns start
+	*/
+	struct MoveLogKeyframe {
+		int64_t turn;
+		uint64_t firstPosition;	/// In the keyframe positions
+		uint64_t count;	/// Players
+		uint64_t firstWord;	/// The moves of turn + 1, then turn + 2... until the next keyframe
+		int32_t originX;
+		int32_t originY;
+		int32_t endX;
+		int32_t endY;
+	};
+	static_assert(sizeof(MoveLogKeyframe) == 48, "The move log keyframes must stay 48 bytes");
+
+	/**
+	* Move log
+	*
+	*	Records the positions of the players turn after turn as the move each one made:
+	*	3 bits per player and turn (none, up, down, left or right), 21 moves per 64-bit word.
+	*	A player that stepped on the end and went back to the origin is recorded as the step.
+	*	A keyframe holds every position after a turn: one every keyframeInterval turns, and
+	*	whenever the moves cannot tell the positions (players added or removed, labyrinth
+	*	loaded, players sent back by an edit).
+	*	A replay starts from the last keyframe before a turn and applies the moves: it only
+	*	reads the log, never the labyrinth nor the players, and gives back the exact positions.
+	*/
+	class MoveLog {
+	public:
+		static const uint32_t version = 1;
+		static const int movesPerWord = 21;
+
+		/**
+		* Replay state
+		*
+		*	The positions of a replay after a turn
+		*/
+		struct ReplayState {
+			ReplayState() : turn(0), keyframe(0), origin(0, 0), end(0, 0) {};
+
+			int64_t turn;
+			size_t keyframe;	/// The keyframe the moves of the next turn belong to
+			Position origin;
+			Position end;
+			std::vector<Position> positions;
+		};
+
+		MoveLog(int64_t keyframeInterval = 1024);
+
+		void clear();
+		void record(int64_t turn, const std::vector<Position>& positions, Position origin, Position end);	/// The positions after a turn (the first call gives the start)
+
+		bool seek(int64_t turn, ReplayState& state) const;	/// The positions after a turn, false if it is not in the log
+		bool advance(ReplayState& state, int64_t turns = 1) const;	/// Replays the next turns, false past the last one
+
+		bool isEmpty() const { return m_keyframes.empty(); }
+		int64_t firstTurn() const { return m_keyframes.empty() ? 0 : m_keyframes.front().turn; }
+		int64_t lastTurn() const { return m_lastTurn; }
+		size_t keyframeCount() const { return m_keyframes.size(); }
+		uint64_t moveCount() const { return m_moveCount; }	/// Player moves recorded as moves (not keyframes)
+		size_t memoryBytes() const;	/// Size of the log (in memory and on disk)
+
+		bool save(const std::string& filename) const;
+		bool load(const std::string& filename);	/// Keeps the current log on failure
+
+	private:
+		static size_t wordsPerTurn(size_t count) { return (count + movesPerWord - 1) / movesPerWord; }
+		void addKeyframe(int64_t turn, const std::vector<Position>& positions, Position origin, Position end);
+		static bool encode(Position* previous, const Position* current, size_t count, Position origin, Position end, uint64_t* words);	/// The moves from previous to current, previous becomes current. False if a player did not make one move
+		uint64_t checksum() const;
+
+		int64_t m_keyframeInterval;
+		int64_t m_lastTurn;
+		uint64_t m_moveCount;
+		std::vector<MoveLogKeyframe> m_keyframes;
+		std::vector<Position> m_keyPositions;	/// The positions of every keyframe, one after the other
+		std::vector<uint64_t> m_words;	/// The moves of every turn, each turn starts on a new word
+		std::vector<Position> m_previous;	/// The positions after the last recorded turn
+	};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace Labyrinth {
+	/**
+	* Object pool
+	*
+	*	Hands out objects allocated by blocks and recycles the released ones,
+	*	so spawning many agents does not mean as many heap allocations.
+	*	Objects never move: the pointers stay valid until released.
+	*	A recycled object is reset in place through T::reset(), so it keeps what it allocated.
+	*/
+	template <typename T>
+	class ObjectPool {
+	public:
+		ObjectPool(size_t blockSize = 4096) : m_blockSize(blockSize), m_used(blockSize) {};
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		/**
+		* Acquire
+		*
+		*	Returns a freshly reset object, recycled if possible
+		*/
+		T* acquire() {
+			if (!m_free.empty()) {
+				T* object = m_free.back();
+				m_free.pop_back();
+				object->reset();
+				return object;
+			}
+			if (m_used == m_blockSize) {
+				m_blocks.emplace_back(new T[m_blockSize]);
+				m_used = 0;
+			}
+			return &m_blocks.back()[m_used++];
+		};
+
+		void release(T* object) { m_free.push_back(object); };	/// Give an object back to the pool
+
+		void reserve(size_t count) { m_free.reserve(count); };	/// Make room to release count objects without reallocating
+
+	private:
+		size_t m_blockSize;	/// Objects per block
+		size_t m_used;	/// Objects handed out from the last block
+		std::vector< std::unique_ptr<T[]> > m_blocks;
+		std::vector<T*> m_free;	/// Released objects, reused first
+	};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Labyrinth {
+	/**
+	* Random
+	*
+	*	Small and fast pseudo-random stream (xoshiro128**, 16 bytes of state).
+	*	Each agent owns one, derived from the simulation seed and the agent id,
+	*	so a seed always replays the same run.
+	*/
+	class Random {
+	public:
+		Random(uint64_t seed = 0, uint64_t stream = 0) { this->seed(seed, stream); };
+
+		/**
+		* Seed
+		*
+		*	Derives an independent stream from a global seed and a stream id (splitmix64)
+		*/
+		void seed(uint64_t seed, uint64_t stream) {
+			uint64_t x(seed ^ (stream * 0xD1B54A32D192ED03ull));
+			for (int i(0); i < 4; i += 2) {
+				uint64_t z(x += 0x9E3779B97F4A7C15ull);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				z ^= z >> 31;
+				state[i] = (uint32_t)z;
+				state[i + 1] = (uint32_t)(z >> 32);
+			}
+			if ((state[0] | state[1] | state[2] | state[3]) == 0)
+				state[0] = 1;	// The all-zero state is a fixed point
+		};
+
+		uint32_t next() {
+			uint32_t result(rotl(state[1] * 5, 7) * 9);
+			uint32_t t(state[1] << 9);
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= t;
+			state[3] = rotl(state[3], 11);
+			return result;
+		};
+
+		uint32_t below(uint32_t bound) { return (uint32_t)(((uint64_t)next() * bound) >> 32); };	/// Uniform in [0, bound), no division nor branch (0 if bound is 0)
+
+		uint32_t state[4];
+
+	private:
+		static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); };
+	};
+}
@@ -0,0 +1,231 @@
+#include "RandomWalk.h"
+
+#include <cstdint>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define LABYRINTH_RANDOMWALK_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define LABYRINTH_TARGET_AVX2
+#else
+#define LABYRINTH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+using namespace Labyrinth;
+
+// The vector path loads the columns as raw 32-bit words
+static_assert(sizeof(Position) == 2 * sizeof(int32_t), "Position must be two packed ints");
+static_assert(sizeof(Random) == 4 * sizeof(uint32_t), "Random must be its bare xoshiro128** state");
+
+namespace {
+	const int deltaX[5] = { 0, 0, 0, -1, 1 };	/// Column offset of each direction
+	const int deltaY[5] = { 0, -1, 1, 0, 0 };	/// Row offset of each direction
+	const int laneAgents[8] = { 0, 1, 4, 5, 2, 3, 6, 7 };	/// Agent of each lane in the vector path
+
+#ifdef LABYRINTH_RANDOMWALK_AVX2
+	bool detectAvx2() {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// AVX, and the OS saves the YMM registers
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	/**
+	* Load states
+	*
+	*	Reads the random states of 8 agents and transposes them: state word k of every
+	*	agent ends up in v k, agents in lanes (0 1 4 5 | 2 3 6 7).
+	*	Mostly blends and shifts, which leave the shuffle port to the rest of the kernel.
+	*/
+	LABYRINTH_TARGET_AVX2 inline void loadStates(const Random* randoms, __m256i& v0, __m256i& v1, __m256i& v2, __m256i& v3) {
+		const __m128i* words = (const __m128i*)randoms;
+		__m256i r0(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(words)), _mm_loadu_si128(words + 2), 1));
+		__m256i r1(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(words + 1)), _mm_loadu_si128(words + 3), 1));
+		__m256i r2(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(words + 4)), _mm_loadu_si128(words + 6), 1));
+		__m256i r3(_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(words + 5)), _mm_loadu_si128(words + 7), 1));
+		// Words 0 and 2, then 1 and 3, of two agents interleaved
+		__m256i t0(_mm256_blend_epi32(r0, _mm256_slli_epi64(r1, 32), 0xAA)), t1(_mm256_blend_epi32(_mm256_srli_epi64(r0, 32), r1, 0xAA));
+		__m256i t2(_mm256_blend_epi32(r2, _mm256_slli_epi64(r3, 32), 0xAA)), t3(_mm256_blend_epi32(_mm256_srli_epi64(r2, 32), r3, 0xAA));
+		v0 = _mm256_unpacklo_epi64(t0, t2);
+		v1 = _mm256_unpacklo_epi64(t1, t3);
+		v2 = _mm256_unpackhi_epi64(t0, t2);
+		v3 = _mm256_unpackhi_epi64(t1, t3);
+	}
+
+	/**
+	* Store states
+	*
+	*	Inverse of loadStates
+	*/
+	LABYRINTH_TARGET_AVX2 inline void storeStates(Random* randoms, __m256i v0, __m256i v1, __m256i v2, __m256i v3) {
+		__m256i t0(_mm256_unpacklo_epi64(v0, v2)), t2(_mm256_unpackhi_epi64(v0, v2));
+		__m256i t1(_mm256_unpacklo_epi64(v1, v3)), t3(_mm256_unpackhi_epi64(v1, v3));
+		__m256i r0(_mm256_blend_epi32(t0, _mm256_slli_epi64(t1, 32), 0xAA)), r1(_mm256_blend_epi32(_mm256_srli_epi64(t0, 32), t1, 0xAA));
+		__m256i r2(_mm256_blend_epi32(t2, _mm256_slli_epi64(t3, 32), 0xAA)), r3(_mm256_blend_epi32(_mm256_srli_epi64(t2, 32), t3, 0xAA));
+		__m128i* words = (__m128i*)randoms;
+		_mm_storeu_si128(words, _mm256_castsi256_si128(r0));
+		_mm_storeu_si128(words + 1, _mm256_castsi256_si128(r1));
+		_mm_storeu_si128(words + 2, _mm256_extracti128_si256(r0, 1));
+		_mm_storeu_si128(words + 3, _mm256_extracti128_si256(r1, 1));
+		_mm_storeu_si128(words + 4, _mm256_castsi256_si128(r2));
+		_mm_storeu_si128(words + 5, _mm256_castsi256_si128(r3));
+		_mm_storeu_si128(words + 6, _mm256_extracti128_si256(r2, 1));
+		_mm_storeu_si128(words + 7, _mm256_extracti128_si256(r3, 1));
+	}
+
+	LABYRINTH_TARGET_AVX2 inline __m256i rotl(__m256i v, int k) {
+		return _mm256_or_si256(_mm256_slli_epi32(v, k), _mm256_srli_epi32(v, 32 - k));
+	}
+#endif
+}
+
+/**
+* Step
+*
+*	Moves every agent of the batch by one cell.
+*	positions, randoms: the columns of the count agents, all DumbAI
+*	reached: receives the index (in the batch) of each agent that reached the end, room for count
+*/
+size_t RandomWalk::step(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached) {
+	size_t done(0), reachedCount(0);
+#ifdef LABYRINTH_RANDOMWALK_AVX2
+	if (isVectorized())
+		done = stepAvx2(labyrinth, origin, end, positions, randoms, count, reached, reachedCount);
+#endif
+	size_t last(reachedCount + stepScalar(labyrinth, origin, end, positions + done, randoms + done, count - done, reached + reachedCount));
+	for (size_t i(reachedCount); i < last; ++i)
+		reached[i] += (uint32_t)done;
+	return last;
+}
+
+bool RandomWalk::isVectorized() {
+#ifdef LABYRINTH_RANDOMWALK_AVX2
+	static const bool avx2(detectAvx2());
+	return avx2;
+#else
+	return false;
+#endif
+}
+
+size_t RandomWalk::stepScalar(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached) {
+	size_t reachedCount(0);
+	for (size_t agent(0); agent < count; ++agent) {
+		Position& position = positions[agent];
+		Surroundings surroundings(labyrinth.surroundings(labyrinth.index(position)));
+		Directions dir(surroundings.nth((int)randoms[agent].below((uint32_t)surroundings.count())));
+		if (dir == none)
+			continue;
+		position.x += deltaX[dir];
+		position.y += deltaY[dir];
+		if (position == end) {
+			position = origin;
+			reached[reachedCount++] = (uint32_t)agent;
+		}
+	}
+	return reachedCount;
+}
+
+#ifdef LABYRINTH_RANDOMWALK_AVX2
+
+/**
+* Step (AVX2)
+*
+*	8 agents per iteration, one per 32-bit lane. The neighbours are fetched with 3 gathers
+*	of 4 bytes around the cell, the draws follow Random::below exactly.
+*/
+LABYRINTH_TARGET_AVX2 size_t RandomWalk::stepAvx2(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached, size_t& reachedCount) {
+	// Gather indices are signed 32-bit
+	if (labyrinth.cellCount() > 0x7FFFFFFF)
+		return 0;
+
+	const int* cells = (const int*)labyrinth.cells();
+	const __m256i one(_mm256_set1_epi32(1)), two(_mm256_set1_epi32(2)), four(_mm256_set1_epi32(4)), eight(_mm256_set1_epi32(8));
+	const __m256i five(_mm256_set1_epi32(5)), nine(_mm256_set1_epi32(9)), fifteen(_mm256_set1_epi32(15));
+	const __m256i zero(_mm256_setzero_si256());
+	const __m256i stride(_mm256_set1_epi32((int)labyrinth.stride()));
+	const __m256i originX(_mm256_set1_epi32(origin.x)), originY(_mm256_set1_epi32(origin.y));
+	const __m256i endX(_mm256_set1_epi32(end.x)), endY(_mm256_set1_epi32(end.y));
+	const __m256i upDir(_mm256_set1_epi32(up)), downDir(_mm256_set1_epi32(down));
+	const __m256i leftDir(_mm256_set1_epi32(left)), rightDir(_mm256_set1_epi32(right));
+
+	// Lookup tables indexed by the free neighbours mask (see Surroundings)
+	const __m256i counts(_mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4));
+	const __m256i lowest(_mm256_setr_epi8(0, 1, 2, 1, 3, 1, 2, 1, 4, 1, 2, 1, 3, 1, 2, 1, 0, 1, 2, 1, 3, 1, 2, 1, 4, 1, 2, 1, 3, 1, 2, 1));
+
+	size_t done(0);
+	for (; done + 8 <= count; done += 8) {
+		__m256i* positionWords = (__m256i*)(positions + done);
+
+		// Agents in lanes (0 1 4 5 | 2 3 6 7)
+		__m256 p0(_mm256_castsi256_ps(_mm256_loadu_si256(positionWords))), p1(_mm256_castsi256_ps(_mm256_loadu_si256(positionWords + 1)));
+		__m256i x(_mm256_castps_si256(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0))));
+		__m256i y(_mm256_castps_si256(_mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1))));
+		__m256i s0, s1, s2, s3;
+		loadStates(randoms + done, s0, s1, s2, s3);
+
+		// Free neighbours: up is byte 1 of the word before the cell above, down is byte 2 two cells
+		// before the cell below (stays in the buffer on the last row), left and right are bytes 0 and 2
+		__m256i index(_mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(y, one), stride), _mm256_add_epi32(x, one)));
+		__m256i above(_mm256_i32gather_epi32(cells, _mm256_sub_epi32(_mm256_sub_epi32(index, stride), one), 1));
+		__m256i below(_mm256_i32gather_epi32(cells, _mm256_sub_epi32(_mm256_add_epi32(index, stride), two), 1));
+		__m256i beside(_mm256_i32gather_epi32(cells, _mm256_sub_epi32(index, one), 1));
+		__m256i walls(_mm256_or_si256(
+			_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(above, 8), one), _mm256_and_si256(_mm256_srli_epi32(below, 15), two)),
+			_mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(beside, 2), four), _mm256_and_si256(_mm256_srli_epi32(beside, 13), eight))));
+		__m256i open(_mm256_xor_si256(walls, fifteen));
+		__m256i freeCount(_mm256_shuffle_epi8(counts, open));
+
+		// xoshiro128** (Random::next)
+		__m256i result(_mm256_mullo_epi32(rotl(_mm256_mullo_epi32(s1, five), 7), nine));
+		__m256i t(_mm256_slli_epi32(s1, 9));
+		s2 = _mm256_xor_si256(s2, s0);
+		s3 = _mm256_xor_si256(s3, s1);
+		s1 = _mm256_xor_si256(s1, s2);
+		s0 = _mm256_xor_si256(s0, s3);
+		s2 = _mm256_xor_si256(s2, t);
+		s3 = rotl(s3, 11);
+
+		// (result * freeCount) >> 32 (Random::below), even and odd lanes apart
+		__m256i even(_mm256_srli_epi64(_mm256_mul_epu32(result, freeCount), 32));
+		__m256i odd(_mm256_mul_epu32(_mm256_srli_epi64(result, 32), _mm256_srli_epi64(freeCount, 32)));
+		__m256i pick(_mm256_blend_epi32(even, odd, 0xAA));
+
+		// The pick-th free direction: drop the lowest free bit pick times, then take the lowest
+		__m256i remaining(open);
+		for (int drop(0); drop < 3; ++drop) {
+			__m256i lowestBit(_mm256_and_si256(remaining, _mm256_sub_epi32(zero, remaining)));
+			remaining = _mm256_andnot_si256(_mm256_and_si256(lowestBit, _mm256_cmpgt_epi32(pick, _mm256_set1_epi32(drop))), remaining);
+		}
+		__m256i dir(_mm256_shuffle_epi8(lowest, remaining));
+
+		// Comparisons give -1 when true
+		x = _mm256_add_epi32(x, _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, leftDir), _mm256_cmpeq_epi32(dir, rightDir)));
+		y = _mm256_add_epi32(y, _mm256_sub_epi32(_mm256_cmpeq_epi32(dir, upDir), _mm256_cmpeq_epi32(dir, downDir)));
+		__m256i arrived(_mm256_andnot_si256(_mm256_cmpeq_epi32(dir, zero), _mm256_and_si256(_mm256_cmpeq_epi32(x, endX), _mm256_cmpeq_epi32(y, endY))));
+		x = _mm256_blendv_epi8(x, originX, arrived);
+		y = _mm256_blendv_epi8(y, originY, arrived);
+		int arrivedLanes(_mm256_movemask_ps(_mm256_castsi256_ps(arrived)));
+		for (int lane(0); arrivedLanes != 0; ++lane, arrivedLanes >>= 1)
+			if (arrivedLanes & 1)
+				reached[reachedCount++] = (uint32_t)(done + laneAgents[lane]);
+
+		_mm256_storeu_si256(positionWords, _mm256_unpacklo_epi32(x, y));
+		_mm256_storeu_si256(positionWords + 1, _mm256_unpackhi_epi32(x, y));
+		storeStates(randoms + done, s0, s1, s2, s3);
+	}
+	return done;
+}
+
+#endif
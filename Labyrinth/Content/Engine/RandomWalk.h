@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "Random.h"
+
+namespace Labyrinth {
+	/**
+	* Random walk
+	*
+	*	Batch turn of a population of DumbAI: every agent moves to one of its free
+	*	neighbours picked uniformly at random, and goes back to the origin when it
+	*	reaches the end. Same draws and same moves as DumbAI::nextMove followed by
+	*	Simulation::moveTo, without a virtual call per agent. The agents that reached the end
+	*	are listed for the caller.
+	*	Runs 8 agents per instruction with AVX2 when the CPU has it, one by one otherwise.
+	*/
+	class RandomWalk {
+	public:
+		static size_t step(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached);	/// Plays one turn for count agents, returns the number of them that reached the end
+
+		static bool isVectorized();	/// True if step uses AVX2 on this CPU
+
+	private:
+		static size_t stepScalar(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached);
+		static size_t stepAvx2(const Grid& labyrinth, Position origin, Position end, Position* positions, Random* randoms, size_t count, uint32_t* reached, size_t& reachedCount);	/// Returns the number of agents done (a multiple of 8)
+	};
+}
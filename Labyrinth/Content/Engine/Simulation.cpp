@@ -0,0 +1,791 @@
+#include "Simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+#include "../Maze/MappedFile.h"
+
+using namespace Labyrinth;
+
+namespace {
+	const size_t playersPerChunk = 4096;	/// Work unit of the parallel phases
+	const size_t checkpointChunk = 65536;	/// Agents copied at once into a checkpoint
+
+	/**
+	* Run end
+	*
+	*	The end of the run of agents of one type starting at first (8 types compared at once)
+	*/
+	size_t runEnd(const AgentType* types, size_t first, size_t last) {
+		uint64_t same(0x0101010101010101ull * types[first]), word;
+		size_t end(first + 1);
+		while (end + 8 <= last) {
+			memcpy(&word, types + end, 8);
+			if (word != same)
+				break;
+			end += 8;
+		}
+		while (end < last && types[end] == types[first])
+			++end;
+		return end;
+	}
+
+	/**
+	* Local statistics
+	*
+	*	The statistics of the chunk of episodes a worker is playing
+	*/
+	EpisodeStatistics& localStatistics() {
+		thread_local EpisodeStatistics statistics;
+		return statistics;
+	}
+
+	/**
+	* Local reached
+	*
+	*	The agents of a RandomWalk batch that reached the end
+	*/
+	std::vector<uint32_t>& localReached() {
+		thread_local std::vector<uint32_t> reached;
+		return reached;
+	}
+
+	/**
+	* Play episodes
+	*
+	*	Episodes [first, last) of one agent: from the origin until the end, or until maxTurns turns.
+	*	Episode i draws from stream i of the seed. Moves like Simulation::moveTo, on Grid indices.
+	*	reset: prepares the agent for a new episode
+	*/
+	template <class Agent, class Reset>
+	void playEpisodes(Agent& agent, const Reset& reset, const Grid& labyrinth, Position origin, Position end,
+		uint64_t seed, uint64_t first, uint64_t last, uint32_t maxTurns, EpisodeStatistics& statistics) {
+		static const int deltaX[5] = { 0, 0, 0, -1, 1 };
+		static const int deltaY[5] = { 0, -1, 1, 0, 0 };
+		const ptrdiff_t offsets[5] = { 0, labyrinth.offset(up), labyrinth.offset(down), labyrinth.offset(left), labyrinth.offset(right) };
+		size_t goal(labyrinth.index(end));
+		for (uint64_t episode(first); episode < last; ++episode) {
+			Random random(seed, episode);
+			reset(agent);
+			Position position(origin);
+			size_t cell(labyrinth.index(origin));
+			uint32_t turns(0);
+			while (cell != goal && turns < maxTurns) {
+				Directions direction(agent.Agent::nextMove(position, labyrinth.surroundings(cell), random));	// No virtual call
+				size_t next(cell + offsets[direction]);
+				if (labyrinth.at(next) != wall) {
+					cell = next;
+					position.x += deltaX[direction];
+					position.y += deltaY[direction];
+				}
+				++turns;
+			}
+			if (cell == goal)
+				statistics.add(turns);
+			else
+				statistics.addUnfinished();
+		}
+	}
+}
+
+/**
+* Constructor
+*
+*	Starts with one manual player and a blank 1x1 labyrinth
+*/
+Simulation::Simulation() :
+	m_originPosition(0, 0),
+	m_endPosition(0, 0),
+	m_componentsSeconds(0.0),
+	m_goalDistancesSeconds(0.0),
+	m_junctionsSeconds(0.0),
+	m_hierarchySeconds(0.0),
+	m_landmarkCount(0),
+	m_landmarksSeconds(0.0),
+	m_lastEditSeconds(0.0),
+	m_seed(0),
+	m_spawnCount(0),
+	m_turnCount(0),
+	m_batchExecution(true),
+	m_moveLog(nullptr) {
+
+	// The first player is controlled with the keyboard
+	m_agents.add(manualAgent, Position(0, 0));
+	m_agents.randoms()[0].seed(m_seed, m_spawnCount++);
+	m_events.push(Event(spawn, 0, Position(0, 0)));
+}
+
+Simulation::~Simulation() {
+}
+
+
+//	##        #######     ###    ########
+//	##       ##     ##   ## ##   ##     ##
+//	##       ##     ##  ##   ##  ##     ##
+//	##       ##     ## ##     ## ##     ##
+//	##       ##     ## ######### ##     ##
+//	##       ##     ## ##     ## ##     ##
+//	########  #######  ##     ## ########
+
+/**
+* Load data from file
+*
+*	Fills the labyrinth from the file supplied. Keeps the current labyrinth on failure.
+*	filename: a path to a text pattern or a binary maze
+*/
+MazeLoadReport Simulation::loadLabyrinthFromFile(const std::string& filename) {
+	MazeLoadReport report = MazeLoader::loadFile(filename, m_labyrinth, m_originPosition, m_endPosition);
+	if (report.success)
+		labyrinthChanged();
+	return report;
+}
+
+/**
+* Load data from memory
+*
+*	Fills the labyrinth from a text pattern. Keeps the current labyrinth on failure.
+*/
+MazeLoadReport Simulation::loadLabyrinthFromText(const char* text, size_t size) {
+	MazeLoadReport report = MazeLoader::loadText(text, size, m_labyrinth, m_originPosition, m_endPosition);
+	if (report.success)
+		labyrinthChanged();
+	return report;
+}
+
+/**
+* Generate labyrinth
+*
+*	Fills the labyrinth with a generated maze, the tiles are carved on the turn workers
+*/
+MazeLoadReport Simulation::generateLabyrinth(MazeGenerator& generator, int sizeX, int sizeY) {
+	MazeLoadReport report = generator.generate(m_labyrinth, sizeX, sizeY, m_originPosition, m_endPosition, m_threadPool.get());
+	if (report.success)
+		labyrinthChanged();
+	return report;
+}
+
+/**
+* Labyrinth changed
+*
+*	Labels the regions first: a labyrinth whose end cannot be reached is known in a few milliseconds.
+*	Sends every player back to the origin and computes the distances to the new end,
+*	once per load rather than once per greedy player or per turn, on all the workers.
+*	Then contracts the corridors and cuts the labyrinth in tiles for the hierarchical searches.
+*/
+void Simulation::labyrinthChanged() {
+	drainEvents();
+	std::fill(m_agents.positions().begin(), m_agents.positions().end(), m_originPosition);
+	std::fill(m_agents.directions().begin(), m_agents.directions().end(), none);
+	std::fill(m_agents.startTurns().begin(), m_agents.startTurns().end(), m_turnCount);
+	analyseLabyrinth();
+}
+
+void Simulation::analyseLabyrinth() {
+	auto start = std::chrono::steady_clock::now();
+	m_components.label(m_labyrinth, m_threadPool.get());
+	m_componentsSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	m_goalDistances.compute(m_labyrinth, m_endPosition, DistanceField::queueSearch, m_threadPool.get());
+	m_goalDistancesSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	m_junctions.build(m_labyrinth);
+	m_junctionsSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	m_hierarchy.build(m_labyrinth, 32, m_threadPool.get());
+	m_hierarchySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	buildLandmarks();
+}
+
+/**
+* Capture checkpoint
+*
+*	The players write their internal state, then each column is copied in one go: the
+*	checkpoint no longer depends on the simulation and can be saved from any thread.
+*	The pending events are counted first, the counters themselves are not saved.
+*/
+void Simulation::captureCheckpoint(Checkpoint& checkpoint) {
+	drainEvents();
+	std::vector<uint32_t>& states = checkpoint.stateWords();
+	states.clear();
+	for (Player* player : m_agents.players())
+		player->saveState(states);
+
+	CheckpointHeader header;
+	memset(&header, 0, sizeof(header));
+	header.sizeX = m_labyrinth.sizeX();
+	header.sizeY = m_labyrinth.sizeY();
+	header.originX = m_originPosition.x;
+	header.originY = m_originPosition.y;
+	header.endX = m_endPosition.x;
+	header.endY = m_endPosition.y;
+	header.batchExecution = m_batchExecution ? 1 : 0;
+	header.seed = m_seed;
+	header.spawnCount = m_spawnCount;
+	header.turnCount = m_turnCount;
+	header.landmarkCount = m_landmarkCount;
+	header.agentCount = m_agents.size();
+	header.wallWords = m_labyrinth.wallStride() * ((size_t)m_labyrinth.sizeY() + 2);
+	checkpoint.layOut(header);
+
+	memcpy(checkpoint.section(wallSection), m_labyrinth.walls(), (size_t)header.wallWords * sizeof(uint64_t));
+	Position* positions = (Position*)checkpoint.section(positionSection);
+	Random* randoms = (Random*)checkpoint.section(randomSection);
+	int64_t* startTurns = (int64_t*)checkpoint.section(startTurnSection);
+	uint32_t* completions = (uint32_t*)checkpoint.section(completionSection);
+	Directions* directions = (Directions*)checkpoint.section(directionSection);
+	AgentType* types = (AgentType*)checkpoint.section(typeSection);
+	auto copyRange = [&](size_t first, size_t last) {
+		std::copy(m_agents.positions().begin() + first, m_agents.positions().begin() + last, positions + first);
+		std::copy(m_agents.randoms().begin() + first, m_agents.randoms().begin() + last, randoms + first);
+		std::copy(m_agents.startTurns().begin() + first, m_agents.startTurns().begin() + last, startTurns + first);
+		std::copy(m_agents.completions().begin() + first, m_agents.completions().begin() + last, completions + first);
+		std::copy(m_agents.directions().begin() + first, m_agents.directions().begin() + last, directions + first);
+		std::copy(m_agents.types().begin() + first, m_agents.types().begin() + last, types + first);
+	};
+
+	// The copies (and the first touch of a new image) are spread over the workers
+	size_t count(m_agents.size());
+	if (m_threadPool && count > checkpointChunk)
+		m_threadPool->parallelFor(count, checkpointChunk, copyRange);
+	else
+		copyRange(0, count);
+}
+
+/**
+* Load checkpoint
+*
+*	Maps the file: the grid reads the walls straight from the mapping, which it keeps, and the
+*	columns of the agents are copied from it in one go each. The regions, the distances, the
+*	graphs and the landmarks are computed again, then the players read back their state.
+*	The event counters start again, the completions of the players go on.
+*	filename: a file written by Checkpoint::save
+*/
+bool Simulation::loadCheckpoint(const std::string& filename) {
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(filename) || !Checkpoint::validate(file->data(), file->size()))
+		return false;
+	CheckpointHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+	size_t count((size_t)header.agentCount);
+	const Position* positions = (const Position*)(file->data() + Checkpoint::sectionOffset(header, positionSection));
+	const Directions* directions = (const Directions*)(file->data() + Checkpoint::sectionOffset(header, directionSection));
+	const AgentType* types = (const AgentType*)(file->data() + Checkpoint::sectionOffset(header, typeSection));
+
+	// The checksum only tells the file is whole: the walls must keep the reads in bounds and the agents stand on free cells
+	const uint64_t* walls = (const uint64_t*)(file->data() + Checkpoint::sectionOffset(header, wallSection));
+	if (!Grid::hasWallBorder(header.sizeX, header.sizeY, walls) || types[0] != manualAgent)
+		return false;
+	size_t wallStride(((size_t)header.sizeX + 65) / 64);
+	for (size_t i(0); i < count; ++i) {
+		if (types[i] > pathfinderAgent || (unsigned)directions[i] > right
+			|| positions[i].x < 0 || positions[i].x >= header.sizeX || positions[i].y < 0 || positions[i].y >= header.sizeY)
+			return false;
+		size_t column((size_t)positions[i].x + 1);
+		if ((walls[((size_t)positions[i].y + 1) * wallStride + column / 64] >> (column % 64)) & 1)
+			return false;
+	}
+
+	drainEvents();
+	m_labyrinth.adoptWalls(header.sizeX, header.sizeY, walls, file);
+	m_originPosition = Position(header.originX, header.originY);
+	m_endPosition = Position(header.endX, header.endY);
+	m_agents.restore(count, types, positions, directions,
+		(const Random*)(file->data() + Checkpoint::sectionOffset(header, randomSection)),
+		(const uint32_t*)(file->data() + Checkpoint::sectionOffset(header, completionSection)),
+		(const int64_t*)(file->data() + Checkpoint::sectionOffset(header, startTurnSection)));
+	m_seed = header.seed;
+	m_spawnCount = header.spawnCount;
+	m_turnCount = header.turnCount;
+	m_batchExecution = header.batchExecution != 0;
+	m_landmarkCount = (size_t)header.landmarkCount;
+	analyseLabyrinth();	// Hands the new goal to the pathfinders
+
+	// From a state that does not read back, the players start as new (a pathfinder plans again)
+	const std::vector<Player*>& players = m_agents.players();
+	const uint32_t* states = (const uint32_t*)(file->data() + Checkpoint::sectionOffset(header, stateSection));
+	const uint32_t* statesEnd = states + header.stateWords;
+	for (size_t i(0); i < count; ++i) {
+		if (types[i] == greedyAgent)
+			static_cast<GreedyAI*>(players[i])->setDistances(&m_goalDistances);
+		if (!players[i]->loadState(states, statesEnd))
+			statesEnd = states;
+	}
+
+	m_lastEvents.clear();
+	m_eventCounters = EventCounters();
+	if (m_moveLog != nullptr)
+		m_moveLog->record(m_turnCount, m_agents.positions(), m_originPosition, m_endPosition);
+	return true;
+}
+
+/**
+* Build landmarks
+*
+*	Chosen in the part of the labyrinth connected to the origin, where the players are
+*/
+void Simulation::buildLandmarks() {
+	auto start = std::chrono::steady_clock::now();
+	m_landmarks.build(m_labyrinth, m_landmarkCount, m_originPosition, m_threadPool.get());
+	m_landmarksSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const std::vector<AgentType>& types = m_agents.types();
+	const std::vector<Player*>& players = m_agents.players();
+	for (size_t i(0); i < types.size(); ++i)
+		if (types[i] == pathfinderAgent)
+			static_cast<PathfinderAI*>(players[i])->setGoal(&m_labyrinth, m_endPosition, getPlanningGraph(), &m_landmarks);
+}
+
+void Simulation::setLandmarkCount(size_t count) {
+	m_landmarkCount = count;
+	buildLandmarks();
+}
+
+/**
+* Is solvable
+*
+*	From the regions, or from the goal distances (kept up to date through the cell edits)
+*/
+bool Simulation::isSolvable() const {
+	if (!m_components.isEmpty())
+		return m_components.connected(m_originPosition, m_endPosition);
+	return m_goalDistances.get(m_originPosition) != DistanceField::unreachable;
+}
+
+/**
+* Planning graph
+*
+*	The hierarchical graph when the labyrinth is too large to plan cell by cell, nullptr otherwise
+*/
+const HierarchicalGraph* Simulation::getPlanningGraph() const {
+	if ((size_t)m_labyrinth.sizeX() * (size_t)m_labyrinth.sizeY() < hierarchicalCells || m_hierarchy.isEmpty())
+		return nullptr;
+	return &m_hierarchy;
+}
+
+
+//	########  ##          ###    ##    ## ######## ########   ######
+//	##     ## ##         ## ##    ##  ##  ##       ##     ## ##    ##
+//	##     ## ##        ##   ##    ####   ##       ##     ## ##
+//	########  ##       ##     ##    ##    ######   ########   ######
+//	##        ##       #########    ##    ##       ##   ##         ##
+//	##        ##       ##     ##    ##    ##       ##    ##  ##    ##
+//	##        ######## ##     ##    ##    ######## ##     ##  ######
+
+/**
+* Add 1 player
+*
+*	Add a new player at the origin
+*/
+AgentHandle Simulation::addPlayer(AgentType type) {
+	addPlayers(1, type);
+	return m_agents.handleAt(m_agents.size() - 1);
+}
+
+/**
+* Add players
+*
+*	Add count new players at the origin, in time proportional to count.
+*	The greedy players share the goal distance field of the simulation,
+*	the pathfinders plan in the labyrinth of the simulation (on its hierarchical graph if it is large).
+*/
+void Simulation::addPlayers(size_t count, AgentType type) {
+	size_t first(m_agents.add(type, count, m_originPosition));
+	std::vector<Random>& randoms = m_agents.randoms();
+	std::vector<int64_t>& startTurns = m_agents.startTurns();
+	for (size_t i(first); i < first + count; ++i) {
+		randoms[i].seed(m_seed, m_spawnCount++);
+		startTurns[i] = m_turnCount;
+		m_events.push(Event(spawn, (uint32_t)i, m_originPosition));
+	}
+	if (type == greedyAgent) {
+		const std::vector<Player*>& players = m_agents.players();
+		for (size_t i(first); i < first + count; ++i)
+			static_cast<GreedyAI*>(players[i])->setDistances(&m_goalDistances);
+	}
+	else if (type == pathfinderAgent) {
+		const std::vector<Player*>& players = m_agents.players();
+		for (size_t i(first); i < first + count; ++i)
+			static_cast<PathfinderAI*>(players[i])->setGoal(&m_labyrinth, m_endPosition, getPlanningGraph(), &m_landmarks);
+	}
+}
+
+/**
+* Set seed
+*
+*	Reseeds every player from the new seed (the player index is its id)
+*/
+void Simulation::setSeed(uint64_t seed) {
+	m_seed = seed;
+	std::vector<Random>& randoms = m_agents.randoms();
+	for (m_spawnCount = 0; m_spawnCount < (uint64_t)randoms.size(); ++m_spawnCount)
+		randoms[(size_t)m_spawnCount].seed(m_seed, m_spawnCount);
+}
+
+/**
+* Remove 1 player
+*
+*	Delete a player (the manual player 0 always stays)
+*	player: the player ID to remove (last added by default or negative ID)
+*/
+void Simulation::removePlayer(int player) {
+	drainEvents();	// Their indices are about to change
+	if (m_agents.size() > 1) {
+		if (player < 0)
+			m_agents.removeAt(m_agents.size() - 1);
+		else if (player > 0 && (size_t)player < m_agents.size())
+			m_agents.removeAt((size_t)player);
+	}
+}
+
+bool Simulation::removePlayer(AgentHandle handle) {
+	if (!m_agents.isValid(handle) || m_agents.indexOf(handle) == 0)
+		return false;
+	drainEvents();
+	return m_agents.remove(handle);
+}
+
+/**
+* Remove players
+*
+*	Delete count players starting at an index, in time proportional to count
+*/
+void Simulation::removePlayers(size_t first, size_t count) {
+	if (first == 0) {	// Keep the manual player
+		if (count == 0)
+			return;
+		first = 1;
+		--count;
+	}
+	drainEvents();
+	m_agents.removeRange(first, count);
+}
+
+Manual* Simulation::getManual() {
+	return (Manual*)(m_agents.players()[0]);
+}
+
+
+//	 ######  ######## ######## ########   ######
+//	##    ##    ##    ##       ##     ## ##    ##
+//	##          ##    ##       ##     ## ##
+//	 ######     ##    ######   ########   ######
+//	      ##    ##    ##       ##              ##
+//	##    ##    ##    ##       ##        ##    ##
+//	 ######     ##    ######## ##         ######
+
+/**
+* Move the cursor by 1 cell
+*
+*	Schedules a move of a player in one direction.
+*	dir: the direction in which the player wants to move
+*	player: the player id (0 by default)
+*/
+void Simulation::moveDirection(Directions dir, int player) {
+	if (player >= 0 && player < getPlayerCount()) {
+		m_agents.directions()[player] = dir;
+	}
+}
+
+/**
+* Move to cell
+*
+*	Move to any cell that is free (not a wall) and not out of bounds, else raises a blocked move.
+*	A player reaching the end raises an event and goes back to the origin.
+*	pos: the destination coordinates
+*	player: the player to move (0 by default)
+*/
+void Simulation::moveTo(Position pos, int player) {
+	if (player >= 0 && player < getPlayerCount()) {
+		if (m_labyrinth.contains(pos) && m_labyrinth.at(m_labyrinth.index(pos)) != wall) {
+			m_agents.positions()[player] = pos;
+			if (pos == m_endPosition) {
+				m_events.push(Event(endReached, (uint32_t)player, pos));
+				m_agents.positions()[player] = m_originPosition;
+			}
+		}
+		else
+			m_events.push(Event(blockedMove, (uint32_t)player, pos));
+	}
+}
+
+Cell Simulation::getCell(Position at) const {
+	return m_labyrinth.get(at);
+}
+
+/**
+* Set cell
+*
+*	The origin and the end stay free. The goal distances and the landmarks only change around
+*	the edit, the tiles touching it are rebuilt and the pathfinders keep their plans unless
+*	they run into the new wall. The players standing in a new wall go back to the origin.
+*/
+bool Simulation::setCell(Position at, Cell cell) {
+	if (!m_labyrinth.contains(at) || at == m_originPosition || at == m_endPosition || m_labyrinth.get(at) == cell)
+		return false;
+	auto start = std::chrono::steady_clock::now();
+	m_labyrinth.set(at, cell);
+	m_goalDistances.repair(m_labyrinth, at);
+	m_hierarchy.update(m_labyrinth, at);
+	m_landmarks.repair(m_labyrinth, at);
+	m_junctions.clear();
+	m_components.clear();
+
+	if (cell == wall) {
+		std::vector<Position>& positions = m_agents.positions();
+		for (size_t i(0); i < positions.size(); ++i)
+			if (positions[i] == at) {
+				positions[i] = m_originPosition;
+				m_agents.startTurns()[i] = m_turnCount;
+			}
+	}
+	const std::vector<AgentType>& types = m_agents.types();
+	const std::vector<Player*>& players = m_agents.players();
+	for (size_t i(0); i < types.size(); ++i)
+		if (types[i] == pathfinderAgent)
+			static_cast<PathfinderAI*>(players[i])->cellChanged(cell);
+	m_lastEditSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
+
+bool Simulation::toggleCell(Position at) {
+	return setCell(at, m_labyrinth.get(at) == wall ? empty : wall);
+}
+
+/**
+* Decide
+*
+*	First phase of a turn: every player schedules its next move from its surroundings
+*/
+void Simulation::decide() {
+	auto start = std::chrono::steady_clock::now();
+	forEachRange(&Simulation::decideRange);
+	m_lastTimings.decideSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_totalTimings.decideSeconds += m_lastTimings.decideSeconds;
+}
+
+void Simulation::decideRange(size_t first, size_t last) {
+	std::vector<Position>& positions = m_agents.positions();
+	std::vector<Directions>& directions = m_agents.directions();
+	std::vector<Random>& randoms = m_agents.randoms();
+	const std::vector<AgentType>& types = m_agents.types();
+	const std::vector<Player*>& players = m_agents.players();
+	size_t player(first);
+	while (player < last) {
+		if (m_batchExecution && types[player] == dumbAgent) {
+			// Moved right away: their move only depends on their own position
+			size_t end(runEnd(types.data(), player, last));
+			std::vector<uint32_t>& reached = localReached();
+			if (reached.size() < end - player)
+				reached.resize(end - player);
+			size_t reachedCount(RandomWalk::step(m_labyrinth, m_originPosition, m_endPosition, &positions[player], &randoms[player], end - player, reached.data()));
+			for (size_t i(0); i < reachedCount; ++i)
+				m_events.push(Event(endReached, (uint32_t)(player + reached[i]), m_endPosition));
+			player = end;
+			continue;
+		}
+		// Players always stand on a playable cell, the border keeps the neighbours in the buffer
+		Surroundings surroundings(m_labyrinth.surroundings(m_labyrinth.index(positions[player])));
+		directions[player] = players[player]->nextMove(positions[player], surroundings, randoms[player]);
+		++player;
+	}
+}
+
+/**
+* Step once
+*
+*	Second phase of a turn: commits the scheduled moves, then drains the events of the turn
+*/
+int64_t Simulation::stepOnce() {
+	auto start = std::chrono::steady_clock::now();
+	forEachRange(&Simulation::commitRange);
+	++m_turnCount;
+	m_lastEvents.clear();
+	m_eventCounters.completionsPerTurn.add((uint32_t)drainEvents());
+	m_lastTimings.commitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	m_totalTimings.commitSeconds += m_lastTimings.commitSeconds;
+
+	if (m_moveLog != nullptr) {
+		start = std::chrono::steady_clock::now();
+		m_moveLog->record(m_turnCount, m_agents.positions(), m_originPosition, m_endPosition);
+		m_lastTimings.recordSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		m_totalTimings.recordSeconds += m_lastTimings.recordSeconds;
+	}
+	return m_turnCount;
+}
+
+/**
+* Set move log
+*
+*	The current positions are the start of the recording
+*/
+void Simulation::setMoveLog(MoveLog* log) {
+	m_moveLog = log;
+	if (m_moveLog != nullptr)
+		m_moveLog->record(m_turnCount, m_agents.positions(), m_originPosition, m_endPosition);
+}
+
+/**
+* Drain events
+*
+*	Single-threaded, between the phases. A player reaching the end took the turns since its
+*	start, and starts again from the origin.
+*/
+size_t Simulation::drainEvents() {
+	size_t first(m_lastEvents.size()), reached(0);
+	m_events.drain(m_lastEvents);
+	std::vector<uint32_t>& completions = m_agents.completions();
+	std::vector<int64_t>& startTurns = m_agents.startTurns();
+	for (size_t i(first); i < m_lastEvents.size(); ++i) {
+		const Event& event = m_lastEvents[i];
+		switch (event.type) {
+		case endReached:
+			++completions[event.agent];
+			m_eventCounters.turnsPerCompletion.add((uint32_t)(m_turnCount - startTurns[event.agent]));
+			startTurns[event.agent] = m_turnCount;
+			++reached;
+			break;
+		case blockedMove:
+			++m_eventCounters.blockedMoves;
+			break;
+		default:
+			++m_eventCounters.spawns;
+		}
+	}
+	m_eventCounters.endReached += reached;
+	return reached;
+}
+
+void Simulation::resetEventCounters() {
+	drainEvents();
+	m_eventCounters = EventCounters();
+	std::fill(m_agents.completions().begin(), m_agents.completions().end(), 0);
+	std::fill(m_agents.startTurns().begin(), m_agents.startTurns().end(), m_turnCount);
+}
+
+void Simulation::commitRange(size_t first, size_t last) {
+	std::vector<Position>& positions = m_agents.positions();
+	std::vector<Directions>& directions = m_agents.directions();
+	const std::vector<AgentType>& types = m_agents.types();
+	for (size_t i(first); i < last; ++i) {
+		if (m_batchExecution && types[i] == dumbAgent) {
+			i = runEnd(types.data(), i, last) - 1;	// Already moved during the decide phase
+			continue;
+		}
+		int player((int)i);
+		switch (directions[player]) {
+		case up:
+			moveTo(Position(positions[player].x, positions[player].y-1), player);
+			break;
+		case down:
+			moveTo(Position(positions[player].x, positions[player].y+1), player);
+			break;
+		case left:
+			moveTo(Position(positions[player].x-1, positions[player].y), player);
+			break;
+		case right:
+			moveTo(Position(positions[player].x+1, positions[player].y), player);
+			break;
+		default:
+			;
+		}
+		directions[player] = none;
+	}
+}
+
+/**
+* For each range
+*
+*	Cuts the players in chunks spread over the workers
+*/
+void Simulation::forEachRange(void (Simulation::*phase)(size_t, size_t)) {
+	size_t count(m_agents.size());
+	if (m_threadPool && count > playersPerChunk)
+		m_threadPool->parallelFor(count, playersPerChunk, [this, phase](size_t first, size_t last) { (this->*phase)(first, last); });
+	else
+		(this->*phase)(0, count);
+}
+
+/**
+* Set worker count
+*
+*	count: the number of threads running the turns (0: one per hardware thread, 1: no thread)
+*/
+void Simulation::setWorkerCount(unsigned count) {
+	if (count == 0)
+		count = ThreadPool::hardwareWorkers();
+	if (count == getWorkerCount())
+		return;
+	drainEvents();
+	m_threadPool.reset(count > 1 ? new ThreadPool(count) : nullptr);
+	m_events.setThreadPool(m_threadPool.get());
+}
+
+/**
+* Run episodes
+*
+*	Each chunk of episodes is played by one worker with its own agent and statistics, which are
+*	then merged: the result does not depend on the number of workers. The players, the turns and
+*	the labyrinth are left as they are. The manual agent has no episode.
+*	episodes: the number of episodes, numbered from 0
+*	maxTurns: an episode still running after maxTurns turns is counted as unfinished
+*	seed: the seed of the episode streams
+*/
+EpisodeStatistics Simulation::runEpisodes(AgentType type, uint64_t episodes, uint32_t maxTurns, uint64_t seed) const {
+	EpisodeStatistics total;
+	if (type == manualAgent)
+		return total;
+	std::mutex totalMutex;
+	const HierarchicalGraph* planningGraph(getPlanningGraph());
+	auto body = [this, type, maxTurns, seed, planningGraph, &total, &totalMutex](size_t first, size_t last) {
+		EpisodeStatistics& statistics = localStatistics();
+		statistics.clear();
+		switch (type) {
+		case greedyAgent: {
+			GreedyAI agent;
+			agent.setDistances(&m_goalDistances);
+			playEpisodes(agent, [](GreedyAI&) {}, m_labyrinth, m_originPosition, m_endPosition, seed, first, last, maxTurns, statistics);
+			break;
+		}
+		case pathfinderAgent: {
+			PathfinderAI agent;
+			auto reset = [this, planningGraph](PathfinderAI& pathfinder) { pathfinder.setGoal(&m_labyrinth, m_endPosition, planningGraph, &m_landmarks); };
+			playEpisodes(agent, reset, m_labyrinth, m_originPosition, m_endPosition, seed, first, last, maxTurns, statistics);
+			break;
+		}
+		default: {
+			DumbAI agent;
+			playEpisodes(agent, [](DumbAI&) {}, m_labyrinth, m_originPosition, m_endPosition, seed, first, last, maxTurns, statistics);
+		}
+		}
+		std::lock_guard<std::mutex> lock(totalMutex);
+		total.merge(statistics);
+	};
+
+	// Enough chunks to balance episodes of very different lengths
+	uint64_t grain(std::max((uint64_t)1, std::min((uint64_t)1024, episodes / ((uint64_t)getWorkerCount() * 64))));
+	if (m_threadPool && episodes > grain)
+		m_threadPool->parallelFor((size_t)episodes, (size_t)grain, body);
+	else
+		body(0, (size_t)episodes);
+	return total;
+}
+
+/**
+* Step
+*
+*	Plays complete turns back to back, as fast as possible
+*	turns: the number of turns to play
+*/
+int64_t Simulation::step(int64_t turns) {
+	for (int64_t turn(0); turn < turns; ++turn) {
+		decide();
+		stepOnce();
+	}
+	return m_turnCount;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "../Maze/MazeLoader.h"
+#include "../Maze/MazeGenerator.h"
+
+#include "../AI/Player.h"
+#include "../AI/DumbAI.h"
+#include "../AI/GreedyAI.h"
+#include "../AI/PathfinderAI.h"
+#include "../AI/Manual.h"
+#include "../Pathfinding/ConnectedComponents.h"
+#include "../Pathfinding/DistanceField.h"
+#include "../Pathfinding/HierarchicalGraph.h"
+#include "../Pathfinding/JunctionGraph.h"
+#include "../Pathfinding/Landmarks.h"
+#include "AgentStore.h"
+#include "Checkpoint.h"
+#include "EpisodeStatistics.h"
+#include "Events.h"
+#include "MoveLog.h"
+#include "RandomWalk.h"
+#include "ThreadPool.h"
+
+namespace Labyrinth {
+
+	/**
+	* Phase timings
+	*
+	*	Wall-clock time spent in each phase of the turns
+	*/
+	struct PhaseTimings {
+		PhaseTimings() : decideSeconds(0.0), commitSeconds(0.0), recordSeconds(0.0) {};
+
+		double decideSeconds;	/// Players choosing their moves
+		double commitSeconds;	/// Scheduled moves being applied
+		double recordSeconds;	/// Positions being written to the move log
+	};
+
+	/**
+	* Simulation
+	*
+	*	The game state (labyrinth, players, turns) and the turn logic.
+	*	Has no platform dependency: it runs headless, the renderer only reads from it.
+	*	A turn is made of two phases: every player decides its next move,
+	*	then all the scheduled moves are committed.
+	*	Both phases can run on several workers: each agent only reads the labyrinth and
+	*	writes its own columns, so the result does not depend on the worker count.
+	*	Runs of DumbAI are played in batch by RandomWalk during the decide phase (same moves,
+	*	no virtual call), unless the batch execution is turned off. Their scheduled directions
+	*	are then ignored.
+	*	Each load starts by labelling the regions of the labyrinth, which tells at once whether
+	*	the end can be reached from the origin.
+	*	The distances to the end are computed once per load; GreedyAI players read them.
+	*	PathfinderAI players plan their own path, again after each load.
+	*	Each load also contracts the corridors of the labyrinth into a JunctionGraph and builds
+	*	the tiles of a HierarchicalGraph; on large labyrinths the pathfinders plan on the tiles.
+	*	Optionally, landmarks are chosen on each load and guide the pathfinders planning cell by cell.
+	*	Cells can be edited between turns: the distances, the tiles and the landmarks are repaired
+	*	around the edit instead of being rebuilt, the regions and the junction graph are dropped
+	*	until the next load.
+	*	The players reaching the end, running into walls and spawning raise events, pushed by the
+	*	workers to their own buffer and drained at the end of each turn into the counters.
+	*	Given a move log, the positions after each turn are recorded for replay.
+	*	Episodes can also be played apart from the players: many independent runs of one agent
+	*	from the origin to the end, spread over the workers, summed up in EpisodeStatistics.
+	*	Between two turns, the whole state can be copied into a Checkpoint and saved on another
+	*	thread; loading it back resumes the same run (the derived data is computed again).
+	*/
+	class Simulation {
+	public:
+		Simulation();
+		~Simulation();
+		Simulation(const Simulation&) = delete;
+		Simulation& operator=(const Simulation&) = delete;
+
+		MazeLoadReport loadLabyrinthFromFile(const std::string& filename);	/// Load a labyrinth file (text or binary), reset the positions and the goal distances
+		MazeLoadReport loadLabyrinthFromText(const char* text, size_t size);	/// Load a text pattern from memory, reset the positions and the goal distances
+		MazeLoadReport generateLabyrinth(MazeGenerator& generator, int sizeX, int sizeY);	/// Generate a new labyrinth (on the workers), reset the positions and the goal distances
+		void captureCheckpoint(Checkpoint& checkpoint);	/// Copy the state into checkpoint, between two turns
+		bool loadCheckpoint(const std::string& filename);	/// Resume from a saved checkpoint, keeps the current state on failure
+
+		void setSeed(uint64_t seed);	/// Reseed every player: the same seed replays the same run
+		uint64_t getSeed() const { return m_seed; }
+
+		AgentHandle addPlayer(AgentType type=dumbAgent);	/// Add a player to the game
+		void addPlayers(size_t count, AgentType type=dumbAgent);	/// Add count players at once
+		void removePlayer(int player=-1);	/// Remove one player (the last added if -1), the last player takes its index
+		bool removePlayer(AgentHandle handle);	/// Remove a player by handle
+		void removePlayers(size_t first, size_t count);	/// Remove count players starting at an index
+
+		Manual* getManual();
+
+		void moveDirection(Directions dir, int player=0);	/// Schedules a move of a player, 1 cell in one direction
+		void moveTo(Position pos, int player=0);	/// Moves a player to another cell
+
+		Cell getCell(Position at) const;
+		bool setCell(Position at, Cell cell);	/// Edit the labyrinth between turns, false if nothing changed (out of bounds, origin, end or same cell)
+		bool toggleCell(Position at);	/// Turn a wall into a free cell or the other way
+		double getLastEditSeconds() const { return m_lastEditSeconds; }	/// Time taken by the repairs of the last edit
+
+		void decide();	/// Asks every player for its next move
+		int64_t stepOnce();	/// Commits the scheduled moves and returns the turn number
+		int64_t step(int64_t turns=1);	/// Plays complete turns (decide + commit) and returns the turn number
+		EpisodeStatistics runEpisodes(AgentType type, uint64_t episodes, uint32_t maxTurns, uint64_t seed) const;	/// Plays episodes of one agent type alone in the labyrinth, on all the workers
+
+		void setWorkerCount(unsigned count);	/// Number of threads running the turns (0: one per hardware thread, 1: no thread)
+		unsigned getWorkerCount() const { return m_threadPool ? m_threadPool->getWorkerCount() : 1; }
+		void setBatchExecution(bool enabled) { m_batchExecution = enabled; }	/// Play the DumbAI through RandomWalk (default) or one virtual call each
+		bool getBatchExecution() const { return m_batchExecution; }
+		void setLandmarkCount(size_t count);	/// Number of landmarks chosen on each load (0, the default: none), rebuilds them now
+		size_t getLandmarkCount() const { return m_landmarkCount; }
+		const PhaseTimings& getLastTimings() const { return m_lastTimings; }	/// Timings of the last turn
+		const PhaseTimings& getTotalTimings() const { return m_totalTimings; }	/// Timings summed over every turn
+		const std::vector<Event>& getLastEvents() const { return m_lastEvents; }	/// The events of the last turn (and the spawns since the turn before)
+		const EventCounters& getEventCounters() const { return m_eventCounters; }	/// Totals since the last reset
+		void resetEventCounters();	/// Clears the totals and the completions of every player, their way to the end starts now
+		void setMoveLog(MoveLog* log);	/// Records every turn from now on in log (owned by the caller, nullptr stops)
+		MoveLog* getMoveLog() const { return m_moveLog; }
+
+		const Grid& getLabyrinth() const { return m_labyrinth; }
+		bool isSolvable() const;	/// The end can be reached from the origin
+		const ConnectedComponents& getComponents() const { return m_components; }	/// The regions of the labyrinth (empty after a cell edit, until the next load)
+		double getComponentsSeconds() const { return m_componentsSeconds; }	/// Time taken by the last labelling
+		const DistanceField& getGoalDistances() const { return m_goalDistances; }	/// Distance of every cell to the end
+		double getGoalDistancesSeconds() const { return m_goalDistancesSeconds; }	/// Time taken by the last distance computation
+		const JunctionGraph& getJunctions() const { return m_junctions; }	/// The corridors of the labyrinth contracted between its junctions
+		double getJunctionsSeconds() const { return m_junctionsSeconds; }	/// Time taken by the last graph build
+		const HierarchicalGraph& getHierarchy() const { return m_hierarchy; }	/// The tiles and entrances of the labyrinth
+		double getHierarchySeconds() const { return m_hierarchySeconds; }	/// Time taken by the last tile build
+		const Landmarks& getLandmarks() const { return m_landmarks; }	/// The landmarks of the labyrinth (empty without setLandmarkCount)
+		double getLandmarksSeconds() const { return m_landmarksSeconds; }	/// Time taken by the last landmark selection
+		Position getOriginPosition() const { return m_originPosition; }
+		Position getEndPosition() const { return m_endPosition; }
+		int getPlayerCount() const { return (int)m_agents.size(); }
+		const std::vector<Position>& getPlayersPosition() const { return m_agents.positions(); }
+		const AgentStore& getAgents() const { return m_agents; }
+		int64_t getTurnCount() const { return m_turnCount; }
+
+	private:
+		const HierarchicalGraph* getPlanningGraph() const;	/// What the pathfinders plan on
+		void buildLandmarks();	/// Choose the landmarks and hand them to the pathfinders
+		void labyrinthChanged();	/// Send every player back to the origin, recompute the goal distances and the graphs
+		void analyseLabyrinth();	/// Label the regions, compute the goal distances, build the graphs and the landmarks
+		size_t drainEvents();	/// Count the pending events and move them to m_lastEvents, returns the number of players that reached the end
+		void decideRange(size_t first, size_t last);	/// Decide phase for players [first, last)
+		void commitRange(size_t first, size_t last);	/// Commit phase for players [first, last)
+		void forEachRange(void (Simulation::*phase)(size_t, size_t));	/// Run a phase over every player, in parallel if possible
+
+		// Labyrinth
+		Grid m_labyrinth;	/// The labyrinth cells (walls), padded with a wall border
+		Position m_originPosition; /// The starting cell position
+		Position m_endPosition;	/// The end cell position
+		ConnectedComponents m_components;	/// Labelled on each load (on all the workers)
+		double m_componentsSeconds;
+		DistanceField m_goalDistances;	/// Distance of every cell to the end, shared by the greedy players
+		double m_goalDistancesSeconds;
+		JunctionGraph m_junctions;	/// Rebuilt on each load
+		double m_junctionsSeconds;
+		HierarchicalGraph m_hierarchy;	/// Rebuilt on each load (on all the workers)
+		double m_hierarchySeconds;
+		static const size_t hierarchicalCells = 256 * 256;	/// The pathfinders plan on m_hierarchy from this labyrinth area
+		Landmarks m_landmarks;	/// Chosen on each load when m_landmarkCount > 0
+		size_t m_landmarkCount;
+		double m_landmarksSeconds;
+		double m_lastEditSeconds;
+
+		// Players
+		AgentStore m_agents;	/// Positions, scheduled directions, random streams and Player objects
+		uint64_t m_seed;	/// The simulation seed, every player stream derives from it
+		uint64_t m_spawnCount;	/// Players created since the last seeding, gives the id of the next one
+
+		// Turns
+		int64_t m_turnCount;	/// The actual turn number
+		bool m_batchExecution;	/// DumbAI runs go through RandomWalk
+		std::unique_ptr<ThreadPool> m_threadPool;	/// Workers for the turn phases (none when single-threaded)
+		PhaseTimings m_lastTimings;
+		PhaseTimings m_totalTimings;
+
+		// Events
+		EventBuffers m_events;	/// One buffer per worker
+		std::vector<Event> m_lastEvents;
+		EventCounters m_eventCounters;
+		MoveLog* m_moveLog;	/// Where the turns are recorded, nullptr if they are not
+	};
+}
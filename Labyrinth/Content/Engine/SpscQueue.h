@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace Labyrinth {
+	/**
+	* SPSC queue
+	*
+	*	Bounded lock-free queue between one producer thread and one consumer thread.
+	*	The indices only grow, the slot is the index modulo the capacity (a power of two).
+	*/
+	template <typename T, size_t Capacity>
+	class SpscQueue {
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	public:
+		SpscQueue() : m_head(0), m_tail(0) {};
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		/**
+		* Push
+		*
+		*	Producer: appends an item, false if the queue is full
+		*/
+		bool push(const T& item) {
+			size_t tail(m_tail.load(std::memory_order_relaxed));
+			if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+				return false;
+			m_items[tail & (Capacity - 1)] = item;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		};
+
+		/**
+		* Pop
+		*
+		*	Consumer: takes the oldest item, false if the queue is empty
+		*/
+		bool pop(T& item) {
+			size_t head(m_head.load(std::memory_order_relaxed));
+			if (head == m_tail.load(std::memory_order_acquire))
+				return false;
+			item = m_items[head & (Capacity - 1)];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		};
+
+	private:
+		T m_items[Capacity];
+		std::atomic<size_t> m_head;	/// Next item to pop, written by the consumer
+		char m_headPadding[64 - sizeof(std::atomic<size_t>)];	/// Keep both indices on their own cache line
+		std::atomic<size_t> m_tail;	/// Next slot to push, written by the producer
+	};
+}
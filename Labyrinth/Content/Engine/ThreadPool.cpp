@@ -0,0 +1,154 @@
+#include "ThreadPool.h"
+
+using namespace Labyrinth;
+
+namespace {
+	thread_local const ThreadPool* workerPool(nullptr);	/// The pool of the worker thread, set once with its index
+	thread_local unsigned workerIndex(0);
+}
+
+ThreadPool::ThreadPool(unsigned workerCount) :
+	m_workerCount(workerCount > 0 ? workerCount : hardwareWorkers()),
+	m_body(nullptr),
+	m_count(0),
+	m_grain(1),
+	m_remainingChunks(0),
+	m_generation(0),
+	m_stopping(false) {
+
+	m_shares.reset(m_workerCount);
+
+	// Worker 0 is the calling thread
+	for (unsigned worker(1); worker < m_workerCount; ++worker)
+		m_threads.emplace_back(&ThreadPool::workerLoop, this, worker);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+unsigned ThreadPool::hardwareWorkers() {
+	unsigned count(std::thread::hardware_concurrency());
+	return count > 0 ? count : 1;
+}
+
+/**
+* Current worker
+*
+*	A worker of another pool (a simulation stepped from a batch worker) runs the loops of pool as worker 0
+*/
+unsigned ThreadPool::currentWorker(const ThreadPool* pool) {
+	return pool != nullptr && workerPool == pool ? workerIndex : 0;
+}
+
+/**
+* Parallel for
+*
+*	Runs body over [0, count) in chunks of grain iterations and returns when all are done
+*	count: the number of iterations
+*	grain: the number of iterations per chunk
+*	body: called with [begin, end) for each chunk, from any worker
+*/
+void ThreadPool::parallelFor(size_t count, size_t grain, const Body& body) {
+	if (count == 0)
+		return;
+	if (grain == 0)
+		grain = 1;
+	size_t chunks((count + grain - 1) / grain);
+	if (m_workerCount == 1 || chunks == 1) {
+		body(0, count);
+		return;
+	}
+
+	// Publish the loop: the body first, then the shares (contiguous chunk ranges)
+	m_body = &body;
+	m_count = count;
+	m_grain = grain;
+	m_remainingChunks.store(chunks);
+	for (unsigned worker(0); worker < m_workerCount; ++worker) {
+		uint64_t begin(chunks * worker / m_workerCount), end(chunks * (worker + 1) / m_workerCount);
+		m_shares[worker].store(begin << 32 | end, std::memory_order_release);
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	runChunks(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_remainingChunks.load() == 0; });
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+	workerPool = this;
+	workerIndex = worker;
+	uint64_t seen(0);
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this, seen] { return m_stopping || m_generation != seen; });
+			if (m_stopping)
+				return;
+			seen = m_generation;
+		}
+		runChunks(worker);
+	}
+}
+
+/**
+* Run chunks
+*
+*	Empties the worker's own share, then steals until every share is empty
+*/
+void ThreadPool::runChunks(unsigned worker) {
+	uint32_t chunk;
+	while (popChunk(worker, chunk) || stealChunk(worker, chunk)) {
+		size_t begin(chunk * m_grain);
+		size_t end(begin + m_grain < m_count ? begin + m_grain : m_count);
+		(*m_body)(begin, end);
+
+		if (m_remainingChunks.fetch_sub(1) == 1) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_done.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::popChunk(unsigned worker, uint32_t& chunk) {
+	std::atomic<uint64_t>& range = m_shares[worker];
+	uint64_t current(range.load(std::memory_order_acquire));
+	while (true) {
+		uint32_t begin((uint32_t)(current >> 32)), end((uint32_t)current);
+		if (begin >= end)
+			return false;
+		if (range.compare_exchange_weak(current, (uint64_t)(begin + 1) << 32 | end, std::memory_order_acq_rel)) {
+			chunk = begin;
+			return true;
+		}
+	}
+}
+
+bool ThreadPool::stealChunk(unsigned thief, uint32_t& chunk) {
+	for (unsigned offset(1); offset < m_workerCount; ++offset) {
+		std::atomic<uint64_t>& range = m_shares[(thief + offset) % m_workerCount];
+		uint64_t current(range.load(std::memory_order_acquire));
+		while (true) {
+			uint32_t begin((uint32_t)(current >> 32)), end((uint32_t)current);
+			if (begin >= end)
+				break;
+			if (range.compare_exchange_weak(current, (uint64_t)begin << 32 | (end - 1), std::memory_order_acq_rel)) {
+				chunk = end - 1;
+				return true;
+			}
+		}
+	}
+	return false;
+}
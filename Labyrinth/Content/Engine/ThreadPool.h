@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CacheLineArray.h"
+
+namespace Labyrinth {
+	/**
+	* Thread pool
+	*
+	*	Fixed set of workers running parallel loops. The iterations are cut in chunks,
+	*	each worker starts with a contiguous share of the chunks and, once done,
+	*	steals chunks from the back of the other workers' shares.
+	*	The calling thread takes part in the loop as worker 0.
+	*/
+	class ThreadPool {
+	public:
+		typedef std::function<void(size_t begin, size_t end)> Body;
+
+		ThreadPool(unsigned workerCount = 0);	/// 0 uses one worker per hardware thread
+		~ThreadPool();
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		unsigned getWorkerCount() const { return m_workerCount; }
+
+		void parallelFor(size_t count, size_t grain, const Body& body);	/// Calls body on [begin, end) chunks of at most grain iterations covering [0, count)
+
+		static unsigned hardwareWorkers();
+		static unsigned currentWorker(const ThreadPool* pool);	/// Index of the calling thread among the workers of pool (0 outside of them: the calling thread is worker 0)
+
+	private:
+		void workerLoop(unsigned worker);
+		void runChunks(unsigned worker);
+		bool popChunk(unsigned worker, uint32_t& chunk);	/// Take the first chunk of a worker's own share
+		bool stealChunk(unsigned thief, uint32_t& chunk);	/// Take the last chunk of another worker's share
+
+		unsigned m_workerCount;
+		std::vector<std::thread> m_threads;
+		CacheLineArray<std::atomic<uint64_t>> m_shares;	/// The chunks left to each worker, packed as (begin << 32 | end) so that the owner (front) and the thieves (back) update them with one CAS
+
+		// Current loop
+		const Body* m_body;
+		size_t m_count;
+		size_t m_grain;
+		std::atomic<size_t> m_remainingChunks;	/// Chunks not finished yet
+
+		// Synchronization
+		std::mutex m_mutex;
+		std::condition_variable m_wake;	/// Workers wait here for a new loop
+		std::condition_variable m_done;	/// The caller waits here for the end of the loop
+		uint64_t m_generation;	/// Incremented for each loop
+		bool m_stopping;
+	};
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Labyrinth {
+	/**
+	* Triple buffer
+	*
+	*	Hands values from one writer thread to one reader thread without locking nor waiting.
+	*	The writer fills the back slot and publishes it, the reader takes the latest published
+	*	slot; the third slot sits in the middle so neither side ever waits for the other.
+	*	Values the reader did not take in time are overwritten (only the latest matters).
+	*/
+	template <typename T>
+	class TripleBuffer {
+	public:
+		TripleBuffer() : m_back(0), m_middle(1), m_front(2) {};
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		T& back() { return m_slots[m_back]; };	/// Writer: the slot to fill, keeps its previous content (reuse its memory)
+
+		/**
+		* Publish
+		*
+		*	Writer: makes the back slot the latest value and takes the middle one as new back slot
+		*/
+		void publish() {
+			uint8_t previous(m_middle.exchange((uint8_t)(m_back | freshBit), std::memory_order_acq_rel));
+			m_back = (uint8_t)(previous & indexMask);
+		};
+
+		/**
+		* Latest
+		*
+		*	Reader: the latest published value, valid until the next call
+		*/
+		const T& latest() {
+			if (m_middle.load(std::memory_order_relaxed) & freshBit) {
+				uint8_t previous(m_middle.exchange(m_front, std::memory_order_acq_rel));
+				m_front = (uint8_t)(previous & indexMask);
+			}
+			return m_slots[m_front];
+		};
+
+		bool hasFresh() const { return (m_middle.load(std::memory_order_relaxed) & freshBit) != 0; };	/// Reader: a value was published since the last call to latest
+
+	private:
+		static const uint8_t indexMask = 3;
+		static const uint8_t freshBit = 4;	/// Set in m_middle when it holds an unread value
+
+		T m_slots[3];
+		uint8_t m_back;	/// Writer side
+		char m_backPadding[63];	/// Keep both sides on their own cache line
+		std::atomic<uint8_t> m_middle;	/// Slot index, plus freshBit
+		char m_middlePadding[63];
+		uint8_t m_front;	/// Reader side
+	};
+}
@@ -0,0 +1,151 @@
+#include "Grid.h"
+
+#include <cstring>
+
+using namespace Labyrinth;
+
+namespace {
+	/**
+	* Expand table
+	*
+	*	8 wall bits -> 8 cells (one byte each, little-endian)
+	*/
+	struct ExpandTable {
+		ExpandTable() {
+			for (int bits(0); bits < 256; ++bits) {
+				cells[bits] = 0;
+				for (int b(0); b < 8; ++b)
+					cells[bits] |= (uint64_t)((bits >> b) & 1) << (8 * b);
+			}
+		}
+		uint64_t cells[256];
+	};
+	const ExpandTable expandTable;
+}
+
+Grid::Grid() :
+	m_sizeX(0),
+	m_sizeY(0),
+	m_stride(0),
+	m_wallStride(0),
+	m_borrowedWalls(nullptr) {
+	reset(0, 0);
+}
+
+/**
+* Reset
+*
+*	Resize the grid, every cell (border included) becomes a wall
+*	sizeX, sizeY: the size of the playable area (at least 1x1 so that (0;0) always exists)
+*/
+void Grid::reset(int sizeX, int sizeY) {
+	m_sizeX = sizeX > 1 ? sizeX : 1;
+	m_sizeY = sizeY > 1 ? sizeY : 1;
+	m_stride = (size_t)m_sizeX + 2;
+	size_t rows((size_t)m_sizeY + 2);
+
+	m_cells.assign(m_stride * rows, (uint8_t)wall);
+
+	m_wallStride = (m_stride + 63) / 64;
+	m_walls.assign(m_wallStride * rows, ~(uint64_t)0);
+	m_borrowedWalls = nullptr;
+	m_wallOwner.reset();
+}
+
+/**
+* Adopt walls
+*
+*	Use a wall bitmap stored elsewhere (typically a mapped file) without copying it.
+*	The cell buffer is rebuilt from the bitmap.
+*	sizeX, sizeY: the size of the playable area
+*	walls: (sizeY + 2) rows of (sizeX + 65) / 64 words, same layout as walls()
+*	owner: keeps the memory behind walls alive as long as the grid uses it
+*/
+void Grid::adoptWalls(int sizeX, int sizeY, const uint64_t* walls, std::shared_ptr<const void> owner) {
+	m_sizeX = sizeX > 1 ? sizeX : 1;
+	m_sizeY = sizeY > 1 ? sizeY : 1;
+	m_stride = (size_t)m_sizeX + 2;
+	m_wallStride = (m_stride + 63) / 64;
+	size_t rows((size_t)m_sizeY + 2);
+
+	m_walls.clear();
+	m_walls.shrink_to_fit();
+	m_borrowedWalls = walls;
+	m_wallOwner = owner;
+
+	// Expand 8 bits at a time into 8 cells
+	m_cells.resize(m_stride * rows);
+	for (size_t row(0); row < rows; ++row) {
+		const uint8_t* bits = (const uint8_t*)(walls + row * m_wallStride);
+		uint8_t* cells = &m_cells[row * m_stride];
+		size_t column(0);
+		for (; column + 8 <= m_stride; column += 8)
+			memcpy(cells + column, &expandTable.cells[bits[column / 8]], 8);
+		for (; column < m_stride; ++column)
+			cells[column] = (bits[column / 8] >> (column % 8)) & 1;
+	}
+}
+
+/**
+* Has wall border
+*
+*	The unchecked neighbour reads rely on the border: a bitmap from a file must be checked
+*	before it is adopted. The first and last rows are all walls, every other row has its first
+*	bit and every bit from the right border column to the end of its last word set.
+*/
+bool Grid::hasWallBorder(int sizeX, int sizeY, const uint64_t* walls) {
+	size_t stride((size_t)sizeX + 2), wallStride((stride + 63) / 64), rows((size_t)sizeY + 2);
+	uint64_t tail(~(uint64_t)0 << ((stride - 1) % 64));
+	for (size_t w(0); w < wallStride; ++w)
+		if (walls[w] != ~(uint64_t)0 || walls[(rows - 1) * wallStride + w] != ~(uint64_t)0)
+			return false;
+	for (size_t row(1); row + 1 < rows; ++row) {
+		const uint64_t* words = walls + row * wallStride;
+		if ((words[0] & 1) == 0 || (words[wallStride - 1] & tail) != tail)
+			return false;
+	}
+	return true;
+}
+
+uint64_t* Grid::wallRow(int y) {
+	ownWalls();
+	return &m_walls[(size_t)(y + 1) * m_wallStride];
+}
+
+void Grid::ownWalls() {
+	if (m_borrowedWalls != nullptr) {
+		m_walls.assign(m_borrowedWalls, m_borrowedWalls + m_wallStride * ((size_t)m_sizeY + 2));
+		m_borrowedWalls = nullptr;
+		m_wallOwner.reset();
+	}
+}
+
+ptrdiff_t Grid::offset(Directions dir, size_t stride) {
+	switch (dir) {
+	case up:
+		return -(ptrdiff_t)stride;
+	case down:
+		return (ptrdiff_t)stride;
+	case left:
+		return -1;
+	case right:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+void Grid::set(Position at, Cell cell) {
+	if (!contains(at))
+		return;
+	size_t i(index(at));
+	m_cells[i] = (uint8_t)cell;
+
+	ownWalls();
+	size_t word((size_t)(at.y + 1) * m_wallStride + (size_t)(at.x + 1) / 64);
+	uint64_t bit((uint64_t)1 << ((at.x + 1) % 64));
+	if (cell == wall)
+		m_walls[word] |= bit;
+	else
+		m_walls[word] &= ~bit;
+}
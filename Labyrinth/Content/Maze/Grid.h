@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "../utils.h"
+
+namespace Labyrinth {
+	/**
+	* Grid
+	*
+	*	Stores the labyrinth cells in one contiguous row-major buffer.
+	*	The playable area is surrounded by a one-cell wall border, so the 4 neighbours
+	*	of any playable cell can be read with a fixed offset and no bounds check.
+	*	A one-bit-per-cell wall bitmap (same padded layout) is kept in sync with the cells.
+	*	The bitmap can be borrowed from a memory-mapped file, it is copied on the first write.
+	*/
+	class Grid {
+	public:
+		Grid();
+
+		void reset(int sizeX, int sizeY);	/// Resize the grid and fill every cell with walls
+		void adoptWalls(int sizeX, int sizeY, const uint64_t* walls, std::shared_ptr<const void> owner);	/// Use an external wall bitmap (kept alive by owner)
+		static bool hasWallBorder(int sizeX, int sizeY, const uint64_t* walls);	/// The border and the padding bits of a bitmap are all walls (required by adoptWalls)
+
+		int sizeX() const { return m_sizeX; }	/// The width in cells of the playable area
+		int sizeY() const { return m_sizeY; }	/// The height in cells of the playable area
+		size_t stride() const { return m_stride; }	/// Distance between two rows in the cell buffer
+		size_t cellCount() const { return m_cells.size(); }	/// Number of cells, border included
+
+		bool contains(Position at) const {
+			return at.x >= 0 && at.x < m_sizeX && at.y >= 0 && at.y < m_sizeY;
+		}
+		size_t index(Position at) const { return (size_t)(at.y + 1) * m_stride + (size_t)(at.x + 1); }	/// Buffer index of a playable cell
+		Position position(size_t index) const { return Position((int)(index % m_stride) - 1, (int)(index / m_stride) - 1); }
+		static ptrdiff_t offset(Directions dir, size_t stride);	/// Index offset to the neighbour in a direction
+		ptrdiff_t offset(Directions dir) const { return offset(dir, m_stride); }
+
+		Cell at(size_t index) const { return (Cell)m_cells[index]; }	/// Unchecked read, the border makes neighbours of playable cells valid
+		Cell get(Position at) const { return contains(at) ? this->at(index(at)) : wall; }	/// Checked read, everything outside is a wall
+		void set(Position at, Cell cell);	/// Write a playable cell, ignored when out of bounds
+		Surroundings surroundings(size_t index) const {	/// The free neighbours of a playable cell, unchecked
+			return Surroundings((unsigned char)((m_cells[index - m_stride] ^ 1)
+				| (m_cells[index + m_stride] ^ 1) << 1
+				| (m_cells[index - 1] ^ 1) << 2
+				| (m_cells[index + 1] ^ 1) << 3));
+		}
+
+		const uint8_t* cells() const { return m_cells.data(); }
+		uint8_t* cellRow(int y) { return &m_cells[index(Position(0, y))]; }	/// Bulk write access to a row, the caller keeps the bitmap in sync
+
+		// Wall bitmap: bit (x+1)%64 of word (y+1)*wallStride + (x+1)/64 is set for a wall
+		size_t wallStride() const { return m_wallStride; }	/// Number of 64-bit words per bitmap row
+		const uint64_t* walls() const { return m_borrowedWalls != nullptr ? m_borrowedWalls : m_walls.data(); }
+		uint64_t* wallRow(int y);	/// Bulk write access to a bitmap row (bit x+1 is cell x)
+		bool isWall(size_t index) const {
+			size_t row(index / m_stride), column(index % m_stride);
+			return (walls()[row * m_wallStride + column / 64] >> (column % 64)) & 1;
+		}
+
+	private:
+		int m_sizeX;	/// The width in cells of the playable area
+		int m_sizeY;	/// The height in cells of the playable area
+		size_t m_stride;	/// sizeX + 2 (border)
+		std::vector<uint8_t> m_cells;	/// (sizeX + 2) * (sizeY + 2) cells, row-major
+
+		size_t m_wallStride;	/// Words per bitmap row
+		std::vector<uint64_t> m_walls;	/// 1 bit per cell, 1 = wall (padding bits are walls too)
+		const uint64_t* m_borrowedWalls;	/// A borrowed bitmap used instead of m_walls (nullptr if none)
+		std::shared_ptr<const void> m_wallOwner;	/// Keeps the borrowed bitmap alive
+
+		void ownWalls();	/// Copy a borrowed bitmap before writing to it
+	};
+}
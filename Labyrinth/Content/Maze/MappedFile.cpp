@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Labyrinth;
+
+MappedFile::MappedFile() :
+	m_open(false),
+	m_data(nullptr),
+	m_size(0),
+#ifdef _WIN32
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr) {
+#else
+	m_fd(-1) {
+#endif
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+/**
+* Open
+*
+*	Map the whole file read-only. An empty file is opened without a view.
+*	filename: the path to the file
+*/
+bool MappedFile::open(const std::string& filename) {
+	close();
+
+#ifdef _WIN32
+	std::wstring wfilename(filename.begin(), filename.end());
+	m_file = CreateFile2(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		close();
+		return false;
+	}
+	m_size = (uint64_t)size.QuadPart;
+
+	if (m_size > 0) {
+		m_mapping = CreateFileMappingFromApp(m_file, nullptr, PAGE_READONLY, 0, nullptr);
+		if (m_mapping == nullptr) {
+			close();
+			return false;
+		}
+		m_data = (const char*)MapViewOfFileFromApp(m_mapping, FILE_MAP_READ, 0, 0);
+		if (m_data == nullptr) {
+			close();
+			return false;
+		}
+	}
+#else
+	m_fd = ::open(filename.c_str(), O_RDONLY);
+	if (m_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0) {
+		close();
+		return false;
+	}
+	m_size = (uint64_t)st.st_size;
+
+	if (m_size > 0) {
+		void* view = mmap(nullptr, (size_t)m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+		if (view == MAP_FAILED) {
+			close();
+			return false;
+		}
+		madvise(view, (size_t)m_size, MADV_SEQUENTIAL);
+		m_data = (const char*)view;
+	}
+#endif
+
+	m_open = true;
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != nullptr)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr)
+		munmap((void*)m_data, (size_t)m_size);
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Labyrinth {
+	/**
+	* Mapped file
+	*
+	*	Read-only memory mapping of a whole file.
+	*	The view stays valid until close() or the destruction of the object.
+	*/
+	class MappedFile {
+	public:
+		MappedFile();
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool open(const std::string& filename);	/// Map the file, returns false if it cannot be opened or mapped
+		void close();	/// Unmap the file
+
+		bool isOpen() const { return m_open; }
+		const char* data() const { return m_data; }	/// The first byte of the file (nullptr for an empty file)
+		uint64_t size() const { return m_size; }	/// The size of the file in bytes
+
+	private:
+		bool m_open;
+		const char* m_data;
+		uint64_t m_size;
+
+#ifdef _WIN32
+		void* m_file;	/// File HANDLE
+		void* m_mapping;	/// File mapping HANDLE
+#else
+		int m_fd;	/// File descriptor
+#endif
+	};
+}
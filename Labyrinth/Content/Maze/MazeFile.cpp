@@ -0,0 +1,124 @@
+#include "MazeFile.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+using namespace Labyrinth;
+
+namespace {
+	const char magicNumber[4] = { 'L', 'B', 'Y', 'R' };
+}
+
+bool MazeFile::isBinary(const char* data, size_t size) {
+	return size >= sizeof(MazeFileHeader) && memcmp(data, magicNumber, sizeof(magicNumber)) == 0;
+}
+
+/**
+* Load
+*
+*	Checks the header, the checksum and the border, then lets the grid read the wall plane
+*	straight from the mapping. The grid keeps the file mapped while it uses it.
+*/
+MazeLoadReport MazeFile::load(std::shared_ptr<MappedFile> file, Grid& grid, Position& origin, Position& end) {
+	auto start = std::chrono::steady_clock::now();
+	MazeLoadReport report;
+
+	if (!file || !isBinary(file->data(), (size_t)file->size()))
+		return report;
+
+	MazeFileHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+	if (header.version != version || header.headerSize != sizeof(MazeFileHeader))
+		return report;
+	if (header.sizeX <= 0 || header.sizeY <= 0)
+		return report;
+	if (header.originX < 0 || header.originX >= header.sizeX || header.originY < 0 || header.originY >= header.sizeY
+		|| header.endX < 0 || header.endX >= header.sizeX || header.endY < 0 || header.endY >= header.sizeY)
+		return report;
+
+	uint64_t wallStride(((uint64_t)header.sizeX + 65) / 64);
+	if (header.wallStride != wallStride || header.wallWords != wallStride * ((uint64_t)header.sizeY + 2))
+		return report;
+	if (file->size() < header.headerSize + header.wallWords * sizeof(uint64_t))
+		return report;
+
+	const uint64_t* walls = (const uint64_t*)(file->data() + header.headerSize);
+	if (checksum(walls, (size_t)header.wallWords) != header.checksum || !Grid::hasWallBorder(header.sizeX, header.sizeY, walls))
+		return report;
+
+	grid.adoptWalls(header.sizeX, header.sizeY, walls, file);
+	origin = Position(header.originX, header.originY);
+	end = Position(header.endX, header.endY);
+
+	report.success = true;
+	report.bytes = file->size();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+/**
+* Save binary
+*
+*	Writes the header followed by the wall plane of the grid
+*/
+bool MazeFile::saveBinary(const std::string& filename, const Grid& grid, Position origin, Position end) {
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	MazeFileHeader header(MazeFile::header(grid.sizeX(), grid.sizeY(), origin, end, checksum(grid.walls(), grid.wallStride() * ((size_t)grid.sizeY() + 2))));
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)grid.walls(), (std::streamsize)(header.wallWords * sizeof(uint64_t)));
+	return out.good();
+}
+
+/**
+* Save text
+*
+*	Writes the pattern format read by MazeLoader
+*/
+bool MazeFile::saveText(const std::string& filename, const Grid& grid, Position origin, Position end) {
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	std::string line((size_t)grid.sizeX() + 1, '\n');
+	for (int y(0); y < grid.sizeY(); ++y) {
+		size_t cell(grid.index(Position(0, y)));
+		for (int x(0); x < grid.sizeX(); ++x, ++cell)
+			line[x] = grid.at(cell) == wall ? '#' : ' ';
+		if (origin.y == y && grid.contains(origin))
+			line[origin.x] = 'O';
+		if (end.y == y && grid.contains(end))
+			line[end.x] = 'E';
+		out.write(line.data(), (std::streamsize)line.size());
+	}
+	return out.good();
+}
+
+MazeFileHeader MazeFile::header(int sizeX, int sizeY, Position origin, Position end, uint64_t checksum) {
+	MazeFileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, magicNumber, sizeof(magicNumber));
+	header.version = version;
+	header.headerSize = sizeof(MazeFileHeader);
+	header.sizeX = sizeX;
+	header.sizeY = sizeY;
+	header.originX = origin.x;
+	header.originY = origin.y;
+	header.endX = end.x;
+	header.endY = end.y;
+	header.wallStride = ((uint64_t)sizeX + 65) / 64;
+	header.wallWords = header.wallStride * ((uint64_t)sizeY + 2);
+	header.checksum = checksum;
+	return header;
+}
+
+uint64_t MazeFile::checksum(const uint64_t* words, size_t count, uint64_t hash) {
+	for (size_t i(0); i < count; ++i) {
+		hash ^= words[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
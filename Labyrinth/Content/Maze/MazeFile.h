@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../utils.h"
+#include "Grid.h"
+#include "MappedFile.h"
+#include "MazeLoader.h"
+
+namespace Labyrinth {
+	/**
+	* Binary maze header
+	*
+	*	64 bytes at the start of a binary maze file, followed by the wall plane:
+	*	wallWords 64-bit words laid out exactly like Grid::walls() (padded rows),
+	*	so a mapped file is used by the grid as is. All fields are little-endian.
+	*/
+	struct MazeFileHeader {
+		char magic[4];	/// "LBYR"
+		uint32_t version;	/// MazeFile::version
+		uint32_t headerSize;	/// sizeof(MazeFileHeader), offset of the wall plane
+		int32_t sizeX;	/// The width in cells of the labyrinth
+		int32_t sizeY;	/// The height in cells of the labyrinth
+		int32_t originX;
+		int32_t originY;
+		int32_t endX;
+		int32_t endY;
+		uint32_t reserved;
+		uint64_t wallStride;	/// Words per wall plane row: (sizeX + 65) / 64
+		uint64_t wallWords;	/// Words in the wall plane: wallStride * (sizeY + 2)
+		uint64_t checksum;	/// MazeFile::checksum of the wall plane
+	};
+	static_assert(sizeof(MazeFileHeader) == 64, "The binary maze header must stay 64 bytes");
+
+	/**
+	* Binary maze file
+	*
+	*	Versioned, bit-packed labyrinth format (1 bit per cell, about 8 times smaller than text).
+	*	Loading maps the file and hands the wall plane to the grid, nothing is parsed.
+	*/
+	class MazeFile {
+	public:
+		static const uint32_t version = 1;
+		static const uint64_t checksumBasis = 14695981039346656037ull;	/// Checksum of no word
+
+		static bool isBinary(const char* data, size_t size);	/// Checks the magic number
+		static MazeLoadReport load(std::shared_ptr<MappedFile> file, Grid& grid, Position& origin, Position& end);	/// Use a mapped binary maze
+		static bool saveBinary(const std::string& filename, const Grid& grid, Position origin, Position end);
+		static bool saveText(const std::string& filename, const Grid& grid, Position origin, Position end);
+		static MazeFileHeader header(int sizeX, int sizeY, Position origin, Position end, uint64_t checksum);	/// The header of a wall plane
+
+		static uint64_t checksum(const uint64_t* words, size_t count, uint64_t hash = checksumBasis);	/// FNV-1a over 64-bit words, continues from hash
+	};
+}
@@ -0,0 +1,391 @@
+#include "MazeGenerator.h"
+
+#include "MazeFile.h"
+#include "../Engine/Random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+using namespace Labyrinth;
+
+namespace {
+	/**
+	* Spanning tree
+	*
+	*	A random spanning tree of a width x height lattice of nodes, the buffers are reused
+	*	from one tile to the next. An edge is stored as node << 1 | 0 to join the node on the
+	*	right, node << 1 | 1 to join the node below.
+	*/
+	struct SpanningTree {
+		std::vector<uint32_t> edges;	/// The tree
+		std::vector<uint32_t> links;	/// Union-find parents (Kruskal), next node of the walk (Wilson)
+		std::vector<uint32_t> pending;	/// Depth-first stack (backtracker), candidate edges (Kruskal)
+		std::vector<uint8_t> marks;	/// Visited (backtracker), in the tree (Wilson), rank (Kruskal)
+
+		void build(MazeGenerator::Algorithm algorithm, uint32_t width, uint32_t height, Random& random) {
+			size_t count((size_t)width * height);
+			edges.clear();
+			if (algorithm == MazeGenerator::wilson)
+				wilson(width, height, count, random);
+			else if (algorithm == MazeGenerator::kruskal)
+				kruskal(width, height, count, random);
+			else
+				backtracker(width, height, count, random);
+		}
+
+		/**
+		* Neighbours
+		*
+		*	The nodes next to a node, returns their number
+		*/
+		static int neighbours(uint32_t node, uint32_t width, uint32_t height, uint32_t around[4]) {
+			uint32_t x(node % width), y(node / width);
+			int count(0);
+			if (y > 0)
+				around[count++] = node - width;
+			if (y + 1 < height)
+				around[count++] = node + width;
+			if (x > 0)
+				around[count++] = node - 1;
+			if (x + 1 < width)
+				around[count++] = node + 1;
+			return count;
+		}
+
+		void join(uint32_t a, uint32_t b, uint32_t width) {
+			uint32_t first(std::min(a, b)), second(std::max(a, b));
+			edges.push_back(first << 1 | (second - first == width ? 1u : 0u));
+		}
+
+		void backtracker(uint32_t width, uint32_t height, size_t count, Random& random) {
+			marks.assign(count, 0);
+			pending.clear();
+			uint32_t start(random.below((uint32_t)count));
+			marks[start] = 1;
+			pending.push_back(start);
+			while (!pending.empty()) {
+				uint32_t node(pending.back());
+				uint32_t around[4], unvisited[4];
+				int free(0), total(neighbours(node, width, height, around));
+				for (int i(0); i < total; ++i)
+					if (marks[around[i]] == 0)
+						unvisited[free++] = around[i];
+				if (free == 0) {
+					pending.pop_back();
+					continue;
+				}
+				uint32_t next(unvisited[random.below((uint32_t)free)]);
+				marks[next] = 1;
+				join(node, next, width);
+				pending.push_back(next);
+			}
+		}
+
+		void wilson(uint32_t width, uint32_t height, size_t count, Random& random) {
+			marks.assign(count, 0);
+			links.resize(count);
+			marks[random.below((uint32_t)count)] = 1;
+			for (uint32_t start(0); start < count; ++start) {
+				// Walk until the tree is met, the last exit of each node erases the loops
+				uint32_t node(start);
+				while (marks[node] == 0) {
+					uint32_t around[4];
+					int total(neighbours(node, width, height, around));
+					links[node] = around[random.below((uint32_t)total)];
+					node = links[node];
+				}
+				for (node = start; marks[node] == 0; node = links[node]) {
+					marks[node] = 1;
+					join(node, links[node], width);
+				}
+			}
+		}
+
+		void kruskal(uint32_t width, uint32_t height, size_t count, Random& random) {
+			pending.clear();
+			for (uint32_t node(0); node < count; ++node) {
+				if (node % width + 1 < width)
+					pending.push_back(node << 1);
+				if (node / width + 1 < height)
+					pending.push_back(node << 1 | 1);
+			}
+			for (size_t i(pending.size()); i > 1; --i)
+				std::swap(pending[i - 1], pending[random.below((uint32_t)i)]);
+
+			links.resize(count);
+			for (uint32_t node(0); node < count; ++node)
+				links[node] = node;
+			marks.assign(count, 0);
+			for (uint32_t edge : pending) {
+				uint32_t a(find(edge >> 1)), b(find((edge & 1) ? (edge >> 1) + width : (edge >> 1) + 1));
+				if (a == b)
+					continue;
+				if (marks[a] < marks[b])
+					std::swap(a, b);
+				links[b] = a;	// Union by rank
+				if (marks[a] == marks[b])
+					++marks[a];
+				edges.push_back(edge);
+			}
+		}
+
+		uint32_t find(uint32_t node) {	/// Set of a node, with path halving
+			while (links[node] != node) {
+				links[node] = links[links[node]];
+				node = links[node];
+			}
+			return node;
+		}
+	};
+
+	SpanningTree& localTree() {
+		static thread_local SpanningTree tree;
+		return tree;
+	}
+}
+
+MazeGenerator::MazeGenerator(Algorithm algorithm, uint64_t seed, int tileRooms) :
+	m_algorithm(algorithm),
+	m_seed(seed),
+	m_tileRooms(tileRooms > 1 ? tileRooms : 1),
+	m_sizeX(0),
+	m_sizeY(0),
+	m_roomsX(0),
+	m_roomsY(0),
+	m_tilesX(0),
+	m_tilesY(0) {
+}
+
+bool MazeGenerator::parseAlgorithm(const std::string& name, Algorithm& algorithm) {
+	if (name == "backtracker")
+		algorithm = recursiveBacktracker;
+	else if (name == "wilson")
+		algorithm = wilson;
+	else if (name == "kruskal")
+		algorithm = kruskal;
+	else
+		return false;
+	return true;
+}
+
+/**
+* Layout
+*
+*	The tiles are joined by a spanning tree drawn from stream 0 of the seed, with one passage
+*	at a random place of each joined border; tile t carves its rooms from stream t + 1
+*/
+void MazeGenerator::layout(int sizeX, int sizeY) {
+	m_sizeX = std::max(sizeX, 3);
+	m_sizeY = std::max(sizeY, 3);
+	m_roomsX = (m_sizeX - 1) / 2;
+	m_roomsY = (m_sizeY - 1) / 2;
+	m_tilesX = (m_roomsX + m_tileRooms - 1) / m_tileRooms;
+	m_tilesY = (m_roomsY + m_tileRooms - 1) / m_tileRooms;
+
+	size_t tiles((size_t)m_tilesX * m_tilesY);
+	m_rightPassages.assign(tiles, -1);
+	m_downPassages.assign(tiles, -1);
+	Random random(m_seed, 0);
+	SpanningTree& tree = localTree();
+	tree.build(m_algorithm, (uint32_t)m_tilesX, (uint32_t)m_tilesY, random);
+	for (uint32_t edge : tree.edges) {
+		size_t tile(edge >> 1);
+		int tileX((int)(tile % m_tilesX)), tileY((int)(tile / m_tilesX));
+		if ((edge & 1) == 0)
+			m_rightPassages[tile] = tileY * m_tileRooms + (int)random.below((uint32_t)std::min(m_tileRooms, m_roomsY - tileY * m_tileRooms));
+		else
+			m_downPassages[tile] = tileX * m_tileRooms + (int)random.below((uint32_t)std::min(m_tileRooms, m_roomsX - tileX * m_tileRooms));
+	}
+}
+
+/**
+* Carve tile
+*
+*	A tile only writes its rooms, the passages between them and its passages to the right and
+*	below: the tiles write disjoint cells and can be carved in parallel.
+*	Room (x, y) is cell (2x + 1, 2y + 1).
+*/
+void MazeGenerator::carveTile(size_t tile, uint8_t* cells, size_t stride, int firstRow) const {
+	int roomX((int)(tile % m_tilesX) * m_tileRooms), roomY((int)(tile / m_tilesX) * m_tileRooms);
+	uint32_t width((uint32_t)std::min(m_tileRooms, m_roomsX - roomX)), height((uint32_t)std::min(m_tileRooms, m_roomsY - roomY));
+	auto open = [cells, stride, firstRow](int x, int y) { cells[(size_t)(y - firstRow) * stride + x] = (uint8_t)empty; };
+
+	Random random(m_seed, tile + 1);
+	SpanningTree& tree = localTree();
+	tree.build(m_algorithm, width, height, random);
+	for (uint32_t y(0); y < height; ++y)
+		for (uint32_t x(0); x < width; ++x)
+			open(2 * (roomX + (int)x) + 1, 2 * (roomY + (int)y) + 1);
+	for (uint32_t edge : tree.edges) {
+		uint32_t node(edge >> 1);
+		int x(2 * (roomX + (int)(node % width)) + 1), y(2 * (roomY + (int)(node / width)) + 1);
+		if ((edge & 1) == 0)
+			open(x + 1, y);
+		else
+			open(x, y + 1);
+	}
+
+	if (m_rightPassages[tile] >= 0)
+		open(2 * (roomX + (int)width), 2 * m_rightPassages[tile] + 1);
+	if (m_downPassages[tile] >= 0)
+		open(2 * m_downPassages[tile] + 1, 2 * (roomY + (int)height));
+}
+
+/**
+* Pack row
+*
+*	The wall bits of the border and of the padding are set
+*/
+void MazeGenerator::packRow(const uint8_t* cells, int sizeX, uint64_t* walls) {
+	size_t words(((size_t)sizeX + 65) / 64);
+	for (size_t word(0); word < words; ++word) {
+		uint64_t bits(~(uint64_t)0);
+		size_t first(word * 64), last(std::min(first + 64, (size_t)sizeX + 1));	// Bitmap columns, column c is cell c - 1
+		for (size_t column(std::max(first, (size_t)1)); column < last; ++column)
+			bits &= ~((uint64_t)(cells[column - 1] != wall) << (column - first));
+		walls[word] = bits;
+	}
+}
+
+/**
+* Generate
+*
+*	Carves every tile of the grid, on the workers given a thread pool, then builds the wall
+*	bitmap row by row
+*/
+MazeLoadReport MazeGenerator::generate(Grid& grid, int sizeX, int sizeY, Position& origin, Position& end, ThreadPool* threadPool) {
+	auto start = std::chrono::steady_clock::now();
+	layout(sizeX, sizeY);
+	grid.reset(m_sizeX, m_sizeY);
+
+	uint8_t* cells = grid.cellRow(0);
+	size_t stride(grid.stride());
+	auto carve = [this, cells, stride](size_t first, size_t last) {
+		for (size_t tile(first); tile < last; ++tile)
+			carveTile(tile, cells, stride, 0);
+	};
+	auto pack = [this, &grid](size_t first, size_t last) {
+		for (size_t y(first); y < last; ++y)
+			packRow(grid.cellRow((int)y), m_sizeX, grid.wallRow((int)y));
+	};
+	size_t tiles((size_t)m_tilesX * m_tilesY);
+	if (threadPool != nullptr) {
+		threadPool->parallelFor(tiles, 1, carve);
+		threadPool->parallelFor((size_t)m_sizeY, 64, pack);
+	}
+	else {
+		carve(0, tiles);
+		pack(0, (size_t)m_sizeY);
+	}
+	origin = Position(1, 1);
+	end = Position(2 * m_roomsX - 1, 2 * m_roomsY - 1);
+
+	MazeLoadReport report;
+	report.success = true;
+	report.bytes = grid.cellCount();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+/**
+* Generate file
+*
+*	Carves one row of tiles at a time into a band of cells, converts the band to text lines
+*	or wall bitmap rows and appends it to the file. The memory used is a few bands, whatever
+*	the size of the labyrinth. The binary header gets its checksum once the plane is written.
+*	bytes: the size of the file
+*/
+MazeLoadReport MazeGenerator::generateFile(const std::string& filename, int sizeX, int sizeY, bool binary, ThreadPool* threadPool) {
+	auto start = std::chrono::steady_clock::now();
+	MazeLoadReport report;
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return report;
+	layout(sizeX, sizeY);
+	Position origin(1, 1), end(2 * m_roomsX - 1, 2 * m_roomsY - 1);
+
+	size_t width((size_t)m_sizeX), wallStride((width + 65) / 64);
+	size_t lineSize(binary ? wallStride * sizeof(uint64_t) : width + 1);
+	std::vector<uint8_t> band((size_t)2 * m_tileRooms * width);
+	std::vector<char> lines((size_t)2 * m_tileRooms * lineSize);
+	uint64_t checksum(MazeFile::checksumBasis);
+	MazeFileHeader header(MazeFile::header(m_sizeX, m_sizeY, origin, end, 0));
+	if (binary)
+		out.write((const char*)&header, sizeof(header));
+
+	// Converts rows [first, last) of the band, starting at labyrinth row y
+	auto convert = [&](size_t first, size_t last, int y) {
+		for (size_t row(first); row < last; ++row) {
+			const uint8_t* cells = &band[row * width];
+			char* line = &lines[row * lineSize];
+			if (binary) {
+				packRow(cells, m_sizeX, (uint64_t*)line);
+				continue;
+			}
+			for (size_t x(0); x < width; ++x)
+				line[x] = cells[x] == wall ? '#' : ' ';
+			line[width] = '\n';
+			if ((int)row + y == origin.y)
+				line[origin.x] = 'O';
+			if ((int)row + y == end.y)
+				line[end.x] = 'E';
+		}
+	};
+	auto write = [&](size_t rows) {
+		if (binary)
+			checksum = MazeFile::checksum((const uint64_t*)lines.data(), rows * wallStride, checksum);
+		out.write(lines.data(), (std::streamsize)(rows * lineSize));
+	};
+	// Walls only: the bitmap border, the top row, the rows below the last room
+	auto writeWalls = [&](int y, int rows) {
+		if (rows <= 0)
+			return;
+		std::fill(band.begin(), band.begin() + rows * width, (uint8_t)wall);
+		convert(0, (size_t)rows, y);
+		write((size_t)rows);
+	};
+
+	if (binary) {
+		std::fill(lines.begin(), lines.begin() + lineSize, (char)-1);
+		write(1);
+	}
+	writeWalls(0, 1);
+	for (int tileY(0); tileY < m_tilesY; ++tileY) {
+		// The band holds the rows of the rooms of the tiles and the row below them
+		int firstRow(2 * tileY * m_tileRooms + 1);
+		int rows(2 * std::min(m_tileRooms, m_roomsY - tileY * m_tileRooms));
+		std::fill(band.begin(), band.begin() + rows * width, (uint8_t)wall);
+		uint8_t* cells = band.data();
+		auto carve = [this, cells, width, firstRow, tileY](size_t first, size_t last) {
+			for (size_t tileX(first); tileX < last; ++tileX)
+				carveTile((size_t)tileY * m_tilesX + tileX, cells, width, firstRow);
+		};
+		auto convertRows = [&](size_t first, size_t last) { convert(first, last, firstRow); };
+		if (threadPool != nullptr) {
+			threadPool->parallelFor((size_t)m_tilesX, 1, carve);
+			threadPool->parallelFor((size_t)rows, 16, convertRows);
+		}
+		else {
+			carve(0, (size_t)m_tilesX);
+			convertRows(0, (size_t)rows);
+		}
+		write((size_t)rows);
+	}
+	writeWalls(2 * m_roomsY + 1, m_sizeY - 2 * m_roomsY - 1);
+	if (binary) {
+		std::fill(lines.begin(), lines.begin() + lineSize, (char)-1);
+		write(1);
+	}
+	report.bytes = (uint64_t)out.tellp();
+	if (binary) {
+		header.checksum = checksum;
+		out.seekp(0);
+		out.write((const char*)&header, sizeof(header));
+	}
+
+	report.success = out.good();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../utils.h"
+#include "../Engine/ThreadPool.h"
+#include "Grid.h"
+#include "MazeLoader.h"
+
+namespace Labyrinth {
+	/**
+	* Maze generator
+	*
+	*	Builds perfect labyrinths (exactly one path between two rooms). The rooms are the cells
+	*	at odd coordinates, the cells between two rooms are walls or passages; the origin is the
+	*	top left room, the end the bottom right one.
+	*	The rooms are cut in square tiles, each one carved on its own by the chosen algorithm,
+	*	with its own random stream. The tiles are joined by a spanning tree over the tiles
+	*	(same algorithm), one passage per joined border: the result is still perfect, and the
+	*	same seed gives the same labyrinth whatever the number of workers.
+	*	Inside a tile Wilson's algorithm draws a uniform spanning tree, the labyrinth as a
+	*	whole is not uniform (the tile borders have one passage each).
+	*	The labyrinth is written into a Grid or streamed to a file one row of tiles at a time,
+	*	so a file can be much larger than the memory.
+	*/
+	class MazeGenerator {
+	public:
+		typedef enum Algorithm_t {
+			recursiveBacktracker,	/// Randomized depth-first search: long winding corridors
+			wilson,	/// Loop-erased random walks: uniform spanning tree of each tile
+			kruskal	/// Walls removed in random order when they join two sets (union-find)
+		} Algorithm;
+
+		MazeGenerator(Algorithm algorithm = recursiveBacktracker, uint64_t seed = 0, int tileRooms = 256);
+
+		MazeLoadReport generate(Grid& grid, int sizeX, int sizeY, Position& origin, Position& end, ThreadPool* threadPool = nullptr);	/// Fill a grid (at least 3x3 cells)
+		MazeLoadReport generateFile(const std::string& filename, int sizeX, int sizeY, bool binary, ThreadPool* threadPool = nullptr);	/// Stream a text pattern or a binary maze file
+
+		static bool parseAlgorithm(const std::string& name, Algorithm& algorithm);	/// "backtracker", "wilson" or "kruskal"
+
+		Algorithm getAlgorithm() const { return m_algorithm; }
+		uint64_t getSeed() const { return m_seed; }
+
+	private:
+		void layout(int sizeX, int sizeY);	/// Cut the rooms in tiles and join the tiles
+		void carveTile(size_t tile, uint8_t* cells, size_t stride, int firstRow) const;	/// Open the rooms and passages of a tile, cell (x, y) is cells[(y - firstRow) * stride + x]
+		static void packRow(const uint8_t* cells, int sizeX, uint64_t* walls);	/// A row of cells to a wall bitmap row (Grid layout)
+
+		Algorithm m_algorithm;
+		uint64_t m_seed;
+		int m_tileRooms;	/// Rooms on a tile side
+
+		// Layout of the labyrinth being generated
+		int m_sizeX;
+		int m_sizeY;
+		int m_roomsX;
+		int m_roomsY;
+		int m_tilesX;
+		int m_tilesY;
+		std::vector<int32_t> m_rightPassages;	/// Per tile: the room row of the passage to the tile on the right, -1 if none
+		std::vector<int32_t> m_downPassages;	/// Per tile: the room column of the passage to the tile below, -1 if none
+	};
+}
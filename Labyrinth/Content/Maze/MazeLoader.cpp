@@ -0,0 +1,176 @@
+#include "MazeLoader.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "MappedFile.h"
+#include "MazeFile.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#define LABYRINTH_LOADER_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Labyrinth;
+
+namespace {
+	/**
+	* Line length
+	*
+	*	Finds the end of the line starting at pos and its length without the line ending
+	*/
+	size_t lineEnd(const char* text, size_t size, size_t pos, size_t& length) {
+		const char* newline = (const char*)memchr(text + pos, '\n', size - pos);
+		size_t end(newline != nullptr ? (size_t)(newline - text) : size);
+		length = end - pos;
+		if (length > 0 && text[end - 1] == '\r')
+			--length;
+		return end;
+	}
+
+	/**
+	* Has marker
+	*
+	*	The pattern holds the marker, in upper or lower case
+	*/
+	bool hasMarker(const char* text, size_t size, char marker) {
+		return memchr(text, marker, size) != nullptr || memchr(text, marker | 0x20, size) != nullptr;
+	}
+
+	/**
+	* Clear wall bits
+	*
+	*	Marks up to 16 cells starting at bit as empty in a bitmap row
+	*/
+	inline void clearWallBits(uint64_t* row, size_t bit, uint64_t mask) {
+		size_t word(bit / 64), shift(bit % 64);
+		row[word] &= ~(mask << shift);
+		if (shift > 48)
+			row[word + 1] &= ~(mask >> (64 - shift));
+	}
+}
+
+/**
+* Load from file
+*
+*	Maps the file in memory. Binary mazes (see MazeFile) are used in place,
+*	text patterns are parsed.
+*	filename: a path to a file containing a pattern
+*/
+MazeLoadReport MazeLoader::loadFile(const std::string& filename, Grid& grid, Position& origin, Position& end) {
+	auto start = std::chrono::steady_clock::now();
+
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	if (!file->open(filename))
+		return MazeLoadReport();
+
+	MazeLoadReport report;
+	if (MazeFile::isBinary(file->data(), (size_t)file->size()))
+		report = MazeFile::load(file, grid, origin, end);
+	else
+		report = loadText(file->data(), (size_t)file->size(), grid, origin, end);
+	if (!report.success)
+		return report;
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+/**
+* Load from memory
+*
+*	A first pass measures the pattern (newlines are found with memchr),
+*	the second one fills the grid row by row.
+*	An empty pattern, or one without an origin or an end, fails and leaves the grid as it was.
+*/
+MazeLoadReport MazeLoader::loadText(const char* text, size_t size, Grid& grid, Position& origin, Position& end) {
+	auto start = std::chrono::steady_clock::now();
+	if (text == nullptr || size == 0 || !hasMarker(text, size, 'O') || !hasMarker(text, size, 'E'))
+		return MazeLoadReport();
+
+	// Measure the labyrinth: one row per line, the longest line gives the width
+	int sizeX(0), sizeY(0);
+	size_t length(0);
+	for (size_t pos(0); pos < size; ++sizeY) {
+		pos = lineEnd(text, size, pos, length) + 1;
+		if ((int)length > sizeX)
+			sizeX = (int)length;
+	}
+
+	// Reset labyrinth data (shorter lines are padded with walls)
+	grid.reset(sizeX, sizeY);
+	origin = Position(0, 0);
+	end = Position(0, 0);
+
+	// Fill the grid
+	int y(0);
+	for (size_t pos(0); pos < size; ++y) {
+		size_t next(lineEnd(text, size, pos, length));
+		fillRow(grid, y, text + pos, length, origin, end);
+		pos = next + 1;
+	}
+
+	MazeLoadReport report;
+	report.success = true;
+	report.bytes = size;
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return report;
+}
+
+/**
+* Fill a row
+*
+*	The row is already made of walls, only the empty cells are written.
+*	16 characters are classified at once when SSE2 is available.
+*/
+void MazeLoader::fillRow(Grid& grid, int y, const char* line, size_t length, Position& origin, Position& end) {
+	uint8_t* cells = grid.cellRow(y);
+	uint64_t* walls = grid.wallRow(y);
+	size_t x(0);
+
+#ifdef LABYRINTH_LOADER_SSE2
+	const __m128i hash = _mm_set1_epi8('#');
+	const __m128i one = _mm_set1_epi8(1);
+	const __m128i lowerCase = _mm_set1_epi8(0x20);
+	const __m128i o = _mm_set1_epi8('o');
+	const __m128i e = _mm_set1_epi8('e');
+	for (; x + 16 <= length; x += 16) {
+		__m128i chars = _mm_loadu_si128((const __m128i*)(line + x));
+		__m128i isWall = _mm_cmpeq_epi8(chars, hash);
+		_mm_storeu_si128((__m128i*)(cells + x), _mm_and_si128(isWall, one));
+		clearWallBits(walls, x + 1, (uint64_t)(~_mm_movemask_epi8(isWall) & 0xFFFF));
+
+		// Origin and end are rare: locate them from a mask
+		__m128i lower = _mm_or_si128(chars, lowerCase);
+		int marks = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(lower, o), _mm_cmpeq_epi8(lower, e)));
+		while (marks != 0) {
+			int i(0);
+			while (((marks >> i) & 1) == 0)
+				++i;
+			marks &= marks - 1;
+			if ((line[x + i] | 0x20) == 'o')
+				origin = Position((int)(x + i), y);
+			else
+				end = Position((int)(x + i), y);
+		}
+	}
+#endif
+
+	for (; x < length; ++x) {
+		switch (line[x]) {
+		case '#':
+			continue;
+		case 'o':
+		case 'O':
+			origin = Position((int)x, y);
+			break;
+		case 'e':
+		case 'E':
+			end = Position((int)x, y);
+			break;
+		default:
+			;
+		}
+		cells[x] = (uint8_t)empty;
+		clearWallBits(walls, x + 1, 1);
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../utils.h"
+#include "Grid.h"
+
+namespace Labyrinth {
+	/**
+	* Maze load report
+	*
+	*	Outcome and throughput of a load
+	*/
+	struct MazeLoadReport {
+		MazeLoadReport() : success(false), bytes(0), seconds(0.0) {};
+
+		double megabytesPerSecond() const { return seconds > 0.0 ? bytes / 1.0e6 / seconds : 0.0; };
+
+		bool success;	/// False if the file could not be opened or mapped, or the pattern has no origin or no end
+		uint64_t bytes;	/// Number of bytes parsed
+		double seconds;	/// Time spent mapping and parsing
+	};
+
+	/**
+	* Maze loader
+	*
+	*	Parses text labyrinth patterns straight into a Grid.
+	*	One line per row: '#' is a wall, 'O' the origin, 'E' the end, anything else is empty.
+	*	Lines may end with "\n" or "\r\n", shorter lines are padded with walls.
+	*	Files in the binary format (see MazeFile) are detected and mapped instead.
+	*/
+	class MazeLoader {
+	public:
+		static MazeLoadReport loadFile(const std::string& filename, Grid& grid, Position& origin, Position& end);	/// Memory-map a file and parse it
+		static MazeLoadReport loadText(const char* text, size_t size, Grid& grid, Position& origin, Position& end);	/// Parse a pattern already in memory
+
+	private:
+		static void fillRow(Grid& grid, int y, const char* line, size_t length, Position& origin, Position& end);
+	};
+}
@@ -0,0 +1,88 @@
+#include "AStar.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Labyrinth;
+
+/**
+* Find path
+*
+*	Plans in the given arena (SearchArena::local() for the calling thread), without allocating
+*	once the arena and waypoints have grown to the size of the labyrinth.
+*	Returns false if a cell is a wall or if the goal cannot be reached.
+*	landmarks: built on this labyrinth, tighten the heuristic (optional)
+*/
+bool AStar::findPath(const Grid& labyrinth, Position from, Position to, std::vector<uint32_t>& waypoints, SearchArena& arena, bool jumpPoints, const Landmarks* landmarks) {
+	waypoints.clear();
+	if (labyrinth.get(from) == wall || labyrinth.get(to) == wall)
+		return false;
+	size_t start(labyrinth.index(from)), goal(labyrinth.index(to));
+	if (start == goal)
+		return true;
+	if (landmarks != nullptr && landmarks->isEmpty())
+		landmarks = nullptr;
+	if (landmarks != nullptr && landmarks->lowerBound(start, goal) == Landmarks::none)
+		return false;	// One cell is connected to the landmarks, the other not
+
+	size_t stride(labyrinth.stride());
+	auto heuristic = [stride, to, goal, landmarks](size_t cell) {
+		int x((int)(cell % stride) - 1), y((int)(cell / stride) - 1);
+		uint32_t manhattan((uint32_t)(std::abs(x - to.x) + std::abs(y - to.y)));
+		if (landmarks == nullptr)
+			return manhattan;
+		uint32_t bound(landmarks->lowerBound(cell, goal));
+		return bound != Landmarks::none && bound > manhattan ? bound : manhattan;
+	};
+
+	arena.reset(labyrinth.cellCount());
+	arena.open(start, 0, start, heuristic(start));
+	SearchArena::OpenNode node;
+	while (arena.popOpen(node)) {
+		if (node.cell == goal) {
+			// Walk the parents back to the start
+			for (size_t cell(goal); cell != start; cell = arena.getParent(cell))
+				waypoints.push_back((uint32_t)cell);
+			std::reverse(waypoints.begin(), waypoints.end());
+			return true;
+		}
+		arena.close(node.cell);
+
+		for (int dir(up); dir <= right; ++dir) {
+			uint32_t steps(1);
+			size_t next(node.cell + labyrinth.offset((Directions)dir));
+			if (jumpPoints)
+				next = jump(labyrinth, node.cell, (Directions)dir, goal, steps);
+			else if (labyrinth.at(next) == wall)
+				continue;
+			if (next == 0 || arena.isClosed(next))
+				continue;
+			uint32_t cost(node.cost + steps);
+			if (!arena.isSeen(next) || cost < arena.getCost(next))
+				arena.open(next, cost, node.cell, heuristic(next));
+		}
+	}
+	return false;
+}
+
+/**
+* Jump
+*
+*	Runs from cell in a direction while the sides stay closed.
+*	Stops on the goal or on a cell with an open side; a wall ahead first means a dead end.
+*	steps: the length of the run
+*/
+size_t AStar::jump(const Grid& labyrinth, size_t cell, Directions dir, size_t goal, uint32_t& steps) {
+	ptrdiff_t ahead(labyrinth.offset(dir));
+	bool vertical(dir == up || dir == down);
+	ptrdiff_t side(vertical ? 1 : (ptrdiff_t)labyrinth.stride());
+	steps = 0;
+	while (true) {
+		cell += ahead;
+		if (labyrinth.at(cell) == wall)
+			return 0;	// The border makes index 0 a wall, never a jump point
+		++steps;
+		if (cell == goal || labyrinth.at(cell - side) != wall || labyrinth.at(cell + side) != wall)
+			return cell;
+	}
+}
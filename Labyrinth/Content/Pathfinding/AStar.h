@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "SearchArena.h"
+#include "Landmarks.h"
+
+namespace Labyrinth {
+	/**
+	* A*
+	*
+	*	Shortest path between two cells, guided by the Manhattan distance.
+	*	With jump points, a cell is only expanded where the path can turn: a move runs
+	*	straight on until a side opens, the goal is met, or a wall stops it (a dead end,
+	*	dropped). Every move costs the same, so the straight runs keep the path optimal
+	*	while a corridor costs one expansion instead of one per cell.
+	*	This is jump point search on a 4-connected grid in its corridor form: open areas,
+	*	where every cell has open sides, are searched cell by cell.
+	*	Given landmarks, the heuristic is the larger of the Manhattan distance and the landmark
+	*	bound (ALT): still a lower bound, but it sees the walls, so far fewer cells are expanded.
+	*/
+	class AStar {
+	public:
+		static bool findPath(const Grid& labyrinth, Position from, Position to, std::vector<uint32_t>& waypoints,
+			SearchArena& arena, bool jumpPoints = true, const Landmarks* landmarks = nullptr);	/// waypoints: the Grid indices where the path turns, the goal last (empty if from is to)
+
+	private:
+		static size_t jump(const Grid& labyrinth, size_t cell, Directions dir, size_t goal, uint32_t& steps);	/// Next jump point from cell, 0 for a dead end
+	};
+}
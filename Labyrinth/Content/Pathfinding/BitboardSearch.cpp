@@ -0,0 +1,199 @@
+#include "BitboardSearch.h"
+
+#include "../Bits.h"
+
+using namespace Labyrinth;
+
+BitboardSearch::BitboardSearch() :
+	m_walls(nullptr),
+	m_wallStride(0),
+	m_sizeX(0),
+	m_sizeY(0),
+	m_distance(0),
+	m_visitedCount(0) {
+}
+
+/**
+* Start
+*
+*	Clears the visited set and makes the start cell the first layer (distance 0).
+*	The grid must not change until the search is over.
+*/
+bool BitboardSearch::start(const Grid& labyrinth, Position start) {
+	m_walls = labyrinth.walls();
+	m_wallStride = labyrinth.wallStride();
+	m_sizeX = labyrinth.sizeX();
+	m_sizeY = labyrinth.sizeY();
+	size_t words(m_wallStride * ((size_t)m_sizeY + 2));
+	m_visited.assign(words, 0);
+	if (m_next.size() != words)
+		m_next.assign(words, 0);
+	m_touched.clear();
+	m_frontier.clear();
+	m_distance = 0;
+	m_visitedCount = 0;
+
+	if (!labyrinth.contains(start) || labyrinth.get(start) == wall)
+		return false;
+	FrontierWord first;
+	first.word = (size_t)(start.y + 1) * m_wallStride + (size_t)(start.x + 1) / 64;
+	first.bits = (uint64_t)1 << ((start.x + 1) % 64);
+	m_visited[first.word] = first.bits;
+	m_frontier.push_back(first);
+	m_visitedCount = 1;
+	return true;
+}
+
+/**
+* Advance
+*
+*	Grows the frontier by one move in every direction.
+*	Left and right are shifts inside a row (bit 63 carries into the next word, bit 0 into the
+*	previous one), up and down are the same bits one bitmap row away. The wall border and
+*	the padding bits keep the candidates inside the playable area.
+*/
+bool BitboardSearch::advance() {
+	if (m_frontier.empty())
+		return false;
+
+	for (const FrontierWord& cells : m_frontier) {
+		uint64_t bits(cells.bits);
+		grow(cells.word, bits << 1 | bits >> 1);
+		grow(cells.word + 1, bits >> 63);
+		grow(cells.word - 1, bits << 63);
+		grow(cells.word - m_wallStride, bits);
+		grow(cells.word + m_wallStride, bits);
+	}
+
+	m_frontier.clear();
+	++m_distance;
+	for (size_t word : m_touched) {
+		uint64_t bits(m_next[word] & ~m_walls[word] & ~m_visited[word]);
+		m_next[word] = 0;
+		if (bits != 0) {
+			m_visited[word] |= bits;
+			m_visitedCount += Bits::popCount(bits);
+			FrontierWord cells;
+			cells.word = word;
+			cells.bits = bits;
+			m_frontier.push_back(cells);
+		}
+	}
+	m_touched.clear();
+	return !m_frontier.empty();
+}
+
+namespace {
+	/**
+	* Fill towards the high bits
+	*
+	*	Extends every seed bit through the free bits above it (Kogge-Stone: 6 doubling steps)
+	*/
+	inline uint64_t fillHigh(uint64_t seeds, uint64_t free) {
+		free &= free << 1;
+		seeds |= free & seeds << 1;
+		free &= free << 1;
+		seeds |= free & seeds << 2;
+		free &= free << 2;
+		seeds |= free & seeds << 4;
+		free &= free << 4;
+		seeds |= free & seeds << 8;
+		free &= free << 8;
+		seeds |= free & seeds << 16;
+		free &= free << 16;
+		seeds |= free & seeds << 32;
+		return seeds;
+	}
+
+	/**
+	* Fill towards the low bits
+	*
+	*	Mirror of fillHigh
+	*/
+	inline uint64_t fillLow(uint64_t seeds, uint64_t free) {
+		free &= free >> 1;
+		seeds |= free & seeds >> 1;
+		free &= free >> 1;
+		seeds |= free & seeds >> 2;
+		free &= free >> 2;
+		seeds |= free & seeds >> 4;
+		free &= free >> 4;
+		seeds |= free & seeds >> 8;
+		free &= free >> 8;
+		seeds |= free & seeds >> 16;
+		free &= free >> 16;
+		seeds |= free & seeds >> 32;
+		return seeds;
+	}
+}
+
+/**
+* Spread
+*
+*	Stacks the neighbours of a word that have a free unreached cell next to the added cells
+*/
+void BitboardSearch::spread(size_t word, uint64_t added) {
+	size_t neighbours[4] = { word - m_wallStride, word + m_wallStride, word + 1, word - 1 };
+	uint64_t touching[4] = { added, added, added >> 63, added << 63 };
+	for (int i(0); i < 4; ++i) {
+		size_t neighbour(neighbours[i]);
+		if ((touching[i] & ~m_walls[neighbour] & ~m_visited[neighbour]) != 0 && m_next[neighbour] == 0) {
+			m_next[neighbour] = 1;
+			m_touched.push_back(neighbour);
+		}
+	}
+}
+
+/**
+* Reach
+*
+*	Flood fill without the layers. A word takes the reached cells next to it (the words above
+*	and below, the edge bits of the words on its sides) and fills its free runs from them in
+*	both directions, whatever their length. The neighbours it can extend to are queued in turn.
+*	A word is only queued when it has a free unreached cell next to a new cell, so open areas
+*	settle 64 cells at a time and narrow corridors cost about one word per corridor step.
+*	visited() then holds the reachable cells, frontier() is left empty.
+*/
+size_t BitboardSearch::reach(const Grid& labyrinth, Position start) {
+	if (!this->start(labyrinth, start))
+		return 0;
+	const FrontierWord first(m_frontier.front());
+	m_frontier.clear();
+
+	// m_touched is the stack of words to fill, m_next[word] flags the stacked words
+	uint64_t free(~m_walls[first.word]);
+	m_visited[first.word] = fillLow(fillHigh(first.bits, free), free);
+	spread(first.word, m_visited[first.word]);
+	while (!m_touched.empty()) {
+		size_t word(m_touched.back());
+		m_touched.pop_back();
+		m_next[word] = 0;
+
+		free = ~m_walls[word];
+		uint64_t seeds(m_visited[word - m_wallStride] | m_visited[word + m_wallStride]
+			| m_visited[word - 1] >> 63 | m_visited[word + 1] << 63);
+		uint64_t cells(fillLow(fillHigh((m_visited[word] | seeds) & free, free), free));
+		uint64_t added(cells & ~m_visited[word]);
+		if (added != 0) {
+			m_visited[word] = cells;
+			spread(word, added);
+		}
+	}
+
+	m_visitedCount = 0;
+	for (uint64_t cells : m_visited)
+		m_visitedCount += Bits::popCount(cells);
+	return m_visitedCount;
+}
+
+bool BitboardSearch::isVisited(Position at) const {
+	if (at.x < 0 || at.x >= m_sizeX || at.y < 0 || at.y >= m_sizeY || m_visited.empty())
+		return false;
+	size_t column((size_t)at.x + 1);
+	return (m_visited[(size_t)(at.y + 1) * m_wallStride + column / 64] >> (column % 64)) & 1;
+}
+
+size_t BitboardSearch::memoryBytes() const {
+	return (m_visited.capacity() + m_next.capacity()) * sizeof(uint64_t) + m_touched.capacity() * sizeof(size_t)
+		+ m_frontier.capacity() * sizeof(FrontierWord);
+}
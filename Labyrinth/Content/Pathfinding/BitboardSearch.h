@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+
+namespace Labyrinth {
+	/**
+	* Bitboard search
+	*
+	*	Breadth-first search over the wall bitmap of a Grid, 64 cells at a time.
+	*	The frontier and the visited set are bitboards with the padded layout of the bitmap:
+	*	a layer grows with shifts (left, right, carry into the next word) and whole-word copies
+	*	(up, down), masked by the free cells and the visited set.
+	*	Only the words holding frontier cells are touched, so a layer costs its own size.
+	*
+	*	Layer by layer: start(), then advance() until it returns false; after each advance()
+	*	frontier() holds the cells at distance getDistance() from the start.
+	*/
+	class BitboardSearch {
+	public:
+		/**
+		* Frontier word
+		*
+		*	The frontier cells of one bitmap word
+		*/
+		struct FrontierWord {
+			size_t word;	/// Index in the bitmap: row * wallStride + column / 64
+			uint64_t bits;	/// Bit column % 64 is set for a frontier cell
+		};
+
+		BitboardSearch();
+
+		bool start(const Grid& labyrinth, Position start);	/// First layer (the start cell alone), false if the start is a wall
+		bool advance();	/// Next layer, false when the search is over
+		size_t reach(const Grid& labyrinth, Position start);	/// Flood fill: every layer at once, returns the number of reachable cells
+
+		const std::vector<FrontierWord>& frontier() const { return m_frontier; }	/// The cells of the current layer
+		uint32_t getDistance() const { return m_distance; }	/// Distance of the current layer to the start
+		size_t getVisitedCount() const { return m_visitedCount; }	/// Cells reached so far, the start included
+		bool isVisited(Position at) const;	/// Whether a cell has been reached so far
+		const std::vector<uint64_t>& visited() const { return m_visited; }	/// Reachability bitmap, same layout as Grid::walls()
+		size_t memoryBytes() const;
+
+	private:
+		void grow(size_t word, uint64_t bits) {	/// Add candidate cells to the next layer
+			if (bits == 0)
+				return;
+			if (m_next[word] == 0)
+				m_touched.push_back(word);
+			m_next[word] |= bits;
+		}
+		void spread(size_t word, uint64_t added);	/// Stack the words reach() can extend to from the added cells
+
+		const uint64_t* m_walls;	/// The bitmap of the searched grid
+		size_t m_wallStride;
+		int m_sizeX;
+		int m_sizeY;
+		std::vector<uint64_t> m_visited;	/// Cells reached by a layer
+		std::vector<uint64_t> m_next;	/// Candidates of the next layer (flags of the stacked words in reach()), back to 0 after each call
+		std::vector<size_t> m_touched;	/// Words of m_next holding candidates (the stack of reach())
+		std::vector<FrontierWord> m_frontier;
+		uint32_t m_distance;
+		size_t m_visitedCount;
+	};
+}
@@ -0,0 +1,152 @@
+#include "ConnectedComponents.h"
+
+#include <algorithm>
+
+using namespace Labyrinth;
+
+const uint32_t ConnectedComponents::none;
+
+ConnectedComponents::ConnectedComponents() :
+	m_stride(0),
+	m_sizeX(0),
+	m_sizeY(0) {
+}
+
+/**
+* Label
+*
+*	1. Each strip of rows joins its free cells to their free left and upper neighbours.
+*	   The strips only touch their own cells and can run in parallel. A run of free cells in a
+*	   row shares the parent of its first cell, and is joined once to each run it touches above.
+*	2. The first row of each strip is joined to the last row of the strip above.
+*	3. Each cell finds its root, the roots are numbered, each cell takes the number of its root.
+*	A root is the first cell of its region, so the numbers follow the order of the regions.
+*/
+void ConnectedComponents::label(const Grid& labyrinth, ThreadPool* threadPool) {
+	m_stride = labyrinth.stride();
+	m_sizeX = labyrinth.sizeX();
+	m_sizeY = labyrinth.sizeY();
+	m_labels.resize(labyrinth.cellCount());
+	m_roots.resize(labyrinth.cellCount());
+
+	size_t workers(threadPool != nullptr ? threadPool->getWorkerCount() : 1);
+	size_t rowsPerStrip(std::max((size_t)16, ((size_t)m_sizeY + workers * 4 - 1) / (workers * 4)));
+	size_t strips(((size_t)m_sizeY + rowsPerStrip - 1) / rowsPerStrip);
+	auto forStrips = [threadPool, this, rowsPerStrip, strips](const ThreadPool::Body& body) {
+		if (threadPool != nullptr && strips > 1)
+			threadPool->parallelFor((size_t)m_sizeY, rowsPerStrip, body);
+		else
+			body(0, (size_t)m_sizeY);
+	};
+	const uint8_t* cells = labyrinth.cells();
+
+	// 1. Local unions, the border rows are walls
+	std::fill(m_labels.begin(), m_labels.begin() + m_stride, none);
+	std::fill(m_labels.end() - m_stride, m_labels.end(), none);
+	forStrips([this, cells](size_t firstRow, size_t lastRow) {
+		for (size_t y(firstRow); y < lastRow; ++y) {
+			uint32_t first((uint32_t)((y + 1) * m_stride));
+			for (uint32_t cell(first); cell < first + m_stride; ++cell) {
+				if (cells[cell] == wall) {
+					m_labels[cell] = none;
+					continue;
+				}
+				bool leftFree(cells[cell - 1] != wall);
+				m_labels[cell] = leftFree ? m_labels[cell - 1] : cell;
+				if (y > firstRow && cells[cell - m_stride] != wall && (!leftFree || cells[cell - m_stride - 1] == wall))
+					unite((uint32_t)(cell - m_stride), cell);
+			}
+		}
+	});
+
+	// 2. Strip borders
+	for (size_t y(rowsPerStrip); y < (size_t)m_sizeY; y += rowsPerStrip) {
+		uint32_t first((uint32_t)((y + 1) * m_stride));
+		for (uint32_t cell(first); cell < first + m_stride; ++cell)
+			if (cells[cell] != wall && cells[cell - m_stride] != wall && (cells[cell - 1] == wall || cells[cell - m_stride - 1] == wall))
+				unite((uint32_t)(cell - m_stride), cell);
+	}
+
+	// 3. Roots (read only), numbered strip by strip
+	std::vector<uint32_t> stripRoots(strips, 0);
+	forStrips([this, cells, rowsPerStrip, &stripRoots](size_t firstRow, size_t lastRow) {
+		uint32_t roots(0);
+		for (size_t cell((firstRow + 1) * m_stride); cell < (lastRow + 1) * m_stride; ++cell) {
+			uint32_t root(m_labels[cell]);
+			if (root == none)
+				continue;
+			if (cells[cell - 1] != wall)
+				root = m_roots[cell - 1];	// Same run
+			else
+				while (m_labels[root] != root)
+					root = m_labels[root];
+			m_roots[cell] = root;
+			roots += root == cell;
+		}
+		stripRoots[firstRow / rowsPerStrip] = roots;
+	});
+	uint32_t total(0);
+	for (uint32_t& roots : stripRoots) {
+		uint32_t first(total);
+		total += roots;
+		roots = first;
+	}
+	forStrips([this, rowsPerStrip, &stripRoots](size_t firstRow, size_t lastRow) {
+		uint32_t number(stripRoots[firstRow / rowsPerStrip]);
+		for (size_t cell((firstRow + 1) * m_stride); cell < (lastRow + 1) * m_stride; ++cell)
+			if (m_labels[cell] != none && m_roots[cell] == cell)
+				m_labels[cell] = number++;
+	});
+	forStrips([this](size_t firstRow, size_t lastRow) {
+		for (size_t cell((firstRow + 1) * m_stride); cell < (lastRow + 1) * m_stride; ++cell)
+			if (m_labels[cell] != none && m_roots[cell] != cell)
+				m_labels[cell] = m_labels[m_roots[cell]];
+	});
+
+	m_sizes.assign(total, 0);
+	for (uint32_t label : m_labels)
+		if (label != none)
+			++m_sizes[label];
+}
+
+void ConnectedComponents::clear() {
+	std::vector<uint32_t>().swap(m_labels);
+	std::vector<uint32_t>().swap(m_roots);
+	std::vector<uint64_t>().swap(m_sizes);
+}
+
+uint32_t ConnectedComponents::get(Position at) const {
+	if (isEmpty() || at.x < 0 || at.x >= m_sizeX || at.y < 0 || at.y >= m_sizeY)
+		return none;
+	return m_labels[(size_t)(at.y + 1) * m_stride + (size_t)(at.x + 1)];
+}
+
+uint32_t ConnectedComponents::largest() const {
+	if (m_sizes.empty())
+		return none;
+	return (uint32_t)(std::max_element(m_sizes.begin(), m_sizes.end()) - m_sizes.begin());
+}
+
+uint64_t ConnectedComponents::cellsApartFrom(uint32_t component) const {
+	uint64_t cells(0);
+	for (uint64_t size : m_sizes)
+		cells += size;
+	return component < m_sizes.size() ? cells - m_sizes[component] : cells;
+}
+
+uint32_t ConnectedComponents::find(uint32_t cell) {
+	while (m_labels[cell] != cell) {
+		m_labels[cell] = m_labels[m_labels[cell]];
+		cell = m_labels[cell];
+	}
+	return cell;
+}
+
+void ConnectedComponents::unite(uint32_t a, uint32_t b) {
+	a = find(a);
+	b = find(b);
+	if (a < b)
+		m_labels[b] = a;
+	else if (b < a)
+		m_labels[a] = b;
+}
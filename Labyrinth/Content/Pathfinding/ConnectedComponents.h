@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "../Engine/ThreadPool.h"
+
+namespace Labyrinth {
+	/**
+	* Connected components
+	*
+	*	Labels the free cells of a labyrinth by region: two cells have the same label if and only
+	*	if a path joins them. Union-find over the cells: each strip of rows is joined on its own
+	*	(on the workers given a thread pool), then the strips are joined along their borders.
+	*	The labels are numbered in the order of their first cell, so they do not depend on the
+	*	number of workers.
+	*/
+	class ConnectedComponents {
+	public:
+		static const uint32_t none = 0xFFFFFFFF;	/// Label of the walls
+
+		ConnectedComponents();
+
+		void label(const Grid& labyrinth, ThreadPool* threadPool = nullptr);
+		void clear();
+
+		uint32_t at(size_t index) const { return m_labels[index]; }	/// Unchecked read by Grid index
+		uint32_t get(Position at) const;	/// Checked read, none outside of the labyrinth
+		bool connected(Position a, Position b) const { return get(a) != none && get(a) == get(b); }
+
+		bool isEmpty() const { return m_labels.empty(); }
+		size_t count() const { return m_sizes.size(); }	/// Number of regions
+		uint64_t size(uint32_t component) const { return m_sizes[component]; }	/// Number of cells of a region
+		uint32_t largest() const;	/// The region with the most cells (none if there are no free cells)
+		uint64_t cellsApartFrom(uint32_t component) const;	/// Free cells outside of a region
+		size_t memoryBytes() const { return (m_labels.capacity() + m_roots.capacity()) * sizeof(uint32_t) + m_sizes.capacity() * sizeof(uint64_t); }
+
+	private:
+		uint32_t find(uint32_t cell);	/// Root of a cell, with path halving
+		void unite(uint32_t a, uint32_t b);	/// The smaller root becomes the root of both
+
+		size_t m_stride;
+		int m_sizeX;
+		int m_sizeY;
+		std::vector<uint32_t> m_labels;	/// Union-find parents while labelling, then the labels
+		std::vector<uint32_t> m_roots;	/// Root of each cell, then the label of each root
+		std::vector<uint64_t> m_sizes;	/// Cells per region
+	};
+}
@@ -0,0 +1,395 @@
+#include "DistanceField.h"
+
+#include "../Bits.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace Labyrinth;
+
+const uint32_t DistanceField::unreachable;
+
+namespace {
+	/**
+	* Claim
+	*
+	*	Sets the bit of a cell, true for the one caller that set it first
+	*/
+	inline bool claim(std::atomic<uint64_t>* claimed, size_t index) {
+		uint64_t bit((uint64_t)1 << (index % 64));
+		std::atomic<uint64_t>& word = claimed[index / 64];
+		if ((word.load(std::memory_order_relaxed) & bit) != 0)
+			return false;
+		return (word.fetch_or(bit, std::memory_order_relaxed) & bit) == 0;
+	}
+}
+
+DistanceField::DistanceField() :
+	m_wide(false),
+	m_stride(0),
+	m_sizeX(0),
+	m_sizeY(0),
+	m_goal(0, 0),
+	m_maxDistance(0),
+	m_reachableCount(0),
+	m_claimedWords(0),
+	m_lastRepairedCount(0) {
+}
+
+/**
+* Compute
+*
+*	Fills the field with the distance of every cell to goal.
+*	The storage width is chosen from the number of playable cells: a path never visits a cell twice.
+*	threadPool: workers for the queue search (optional)
+*/
+void DistanceField::compute(const Grid& labyrinth, Position goal, SearchMethod method, ThreadPool* threadPool) {
+	m_stride = labyrinth.stride();
+	m_sizeX = labyrinth.sizeX();
+	m_sizeY = labyrinth.sizeY();
+	m_goal = goal;
+	m_maxDistance = 0;
+	m_reachableCount = 0;
+	m_layerSizes.clear();
+
+	m_wide = (uint64_t)m_sizeX * (uint64_t)m_sizeY >= shortUnreachable;
+	if (m_wide) {
+		std::vector<uint16_t>().swap(m_short);
+		search(labyrinth, m_long, unreachable, method, threadPool);
+	}
+	else {
+		std::vector<uint32_t>().swap(m_long);
+		search(labyrinth, m_short, shortUnreachable, method, threadPool);
+	}
+}
+
+void DistanceField::clear() {
+	std::vector<uint16_t>().swap(m_short);
+	std::vector<uint32_t>().swap(m_long);
+	m_maxDistance = 0;
+	m_reachableCount = 0;
+	m_layerSizes.clear();
+}
+
+template <typename T>
+void DistanceField::search(const Grid& labyrinth, std::vector<T>& distances, T sentinel, SearchMethod method, ThreadPool* threadPool) {
+	bool parallel(threadPool != nullptr && threadPool->getWorkerCount() > 1 && method == queueSearch);
+	if (parallel && distances.size() == labyrinth.cellCount())	// Same size as the last labyrinth: reset in place
+		threadPool->parallelFor(distances.size(), cellsPerChunk * 16, [&distances, sentinel](size_t first, size_t last) {
+			std::fill(distances.begin() + first, distances.begin() + last, sentinel);
+		});
+	else
+		distances.assign(labyrinth.cellCount(), sentinel);
+	if (!labyrinth.contains(m_goal) || labyrinth.get(m_goal) == wall)
+		return;
+	if (parallel)
+		parallelFill(labyrinth, distances, *threadPool);
+	else if (method == bitboardSearch)
+		bitboardFill(labyrinth, distances);
+	else
+		queueFill(labyrinth, distances);
+}
+
+/**
+* Queue fill
+*
+*	Level-synchronous breadth-first search: every cell of the frontier is at the same distance,
+*	their unvisited free neighbours make the next frontier
+*/
+template <typename T>
+void DistanceField::queueFill(const Grid& labyrinth, std::vector<T>& distances) {
+	const T sentinel(distances.front());	// The border is unreachable
+	const ptrdiff_t offsets[4] = { -(ptrdiff_t)m_stride, (ptrdiff_t)m_stride, -1, 1 };
+	std::vector<size_t> frontier, next;
+	frontier.push_back(labyrinth.index(m_goal));
+	distances[frontier.front()] = 0;
+	T distance(0);
+	while (!frontier.empty()) {
+		m_reachableCount += frontier.size();
+		m_layerSizes.push_back(frontier.size());
+		m_maxDistance = distance;
+		++distance;
+		next.clear();
+		for (size_t cell : frontier) {
+			// The wall border stops the search at the edges
+			for (int dir(0); dir < 4; ++dir) {
+				size_t neighbour(cell + offsets[dir]);
+				if (distances[neighbour] == sentinel && labyrinth.at(neighbour) != wall) {
+					distances[neighbour] = distance;
+					next.push_back(neighbour);
+				}
+			}
+		}
+		frontier.swap(next);
+	}
+}
+
+/**
+* Bitboard fill
+*
+*	Lets BitboardSearch find the layers and writes the distance of their cells.
+*	A bitmap word maps to 64 consecutive cells of the same row.
+*/
+template <typename T>
+void DistanceField::bitboardFill(const Grid& labyrinth, std::vector<T>& distances) {
+	if (!m_bitboard.start(labyrinth, m_goal))
+		return;
+	size_t wallStride(labyrinth.wallStride());
+	do {
+		T distance((T)m_bitboard.getDistance());
+		size_t layerSize(0);
+		for (const BitboardSearch::FrontierWord& cells : m_bitboard.frontier()) {
+			size_t row(cells.word / wallStride);
+			T* first = &distances[row * m_stride + (cells.word - row * wallStride) * 64];
+			layerSize += Bits::popCount(cells.bits);
+			for (uint64_t bits(cells.bits); bits != 0; bits &= bits - 1)
+				first[Bits::lowest(bits)] = distance;
+		}
+		m_layerSizes.push_back(layerSize);
+		m_maxDistance = distance;
+	} while (m_bitboard.advance());
+	m_reachableCount = m_bitboard.getVisitedCount();
+}
+
+/**
+* Parallel fill
+*
+*	Level-synchronous breadth-first search like queueFill. A layer is cut in chunks, each chunk
+*	writes the cells it reaches in its own buffer; the buffers are joined into the next layer.
+*	A cell is taken by whichever worker sets its bit in m_claimed first, but all the candidates
+*	of a layer get the same distance, so the field is the same as on one thread.
+*/
+template <typename T>
+void DistanceField::parallelFill(const Grid& labyrinth, std::vector<T>& distances, ThreadPool& threadPool) {
+	// The walls are claimed from the start (the bits past the last cell are never read)
+	size_t cellCount(labyrinth.cellCount());
+	size_t words((cellCount + 63) / 64);
+	if (m_claimedWords != words) {
+		m_claimed.reset(new std::atomic<uint64_t>[words]);
+		m_claimedWords = words;
+	}
+	const uint8_t* cells = labyrinth.cells();
+	std::atomic<uint64_t>* claimed = m_claimed.get();
+	threadPool.parallelFor(words, cellsPerChunk, [cells, cellCount, claimed](size_t first, size_t last) {
+		for (size_t word(first); word < last; ++word) {
+			uint64_t bits(0);
+			size_t end(std::min(word * 64 + 64, cellCount));
+			for (size_t cell(word * 64); cell < end; ++cell)
+				bits |= (uint64_t)(cells[cell] == wall) << (cell % 64);
+			claimed[word].store(bits, std::memory_order_relaxed);
+		}
+	});
+
+	const ptrdiff_t offsets[4] = { -(ptrdiff_t)m_stride, (ptrdiff_t)m_stride, -1, 1 };
+	std::vector<size_t> frontier(1, labyrinth.index(m_goal));
+	claim(claimed, frontier.front());
+	distances[frontier.front()] = 0;
+	T distance(0);
+	while (!frontier.empty()) {
+		m_reachableCount += frontier.size();
+		m_layerSizes.push_back(frontier.size());
+		m_maxDistance = distance;
+		++distance;
+
+		size_t chunks((frontier.size() + cellsPerChunk - 1) / cellsPerChunk);
+		if (m_chunkFrontiers.size() < chunks)
+			m_chunkFrontiers.resize(chunks);
+		auto expand = [&](size_t first, size_t last) {
+			std::vector<size_t>& next = m_chunkFrontiers[first / cellsPerChunk];
+			next.clear();
+			for (size_t i(first); i < last; ++i) {
+				for (int dir(0); dir < 4; ++dir) {
+					size_t neighbour(frontier[i] + offsets[dir]);
+					if (claim(claimed, neighbour)) {
+						distances[neighbour] = distance;
+						next.push_back(neighbour);
+					}
+				}
+			}
+		};
+		if (chunks == 1)
+			expand(0, frontier.size());
+		else
+			threadPool.parallelFor(frontier.size(), cellsPerChunk, expand);
+
+		frontier.clear();
+		for (size_t chunk(0); chunk < chunks; ++chunk)
+			frontier.insert(frontier.end(), m_chunkFrontiers[chunk].begin(), m_chunkFrontiers[chunk].end());
+	}
+}
+
+/**
+* Repair
+*
+*	Call after a cell of the labyrinth (the same size as when computed) became a wall or free.
+*	Only the cells whose distance changes are written: a new wall lengthens the paths that went
+*	through it, a new free cell shortens the paths that can go through it. Changing the goal
+*	cell computes the whole field again.
+*/
+size_t DistanceField::repair(const Grid& labyrinth, Position changed) {
+	m_lastRepairedCount = 0;
+	if (isEmpty() || !labyrinth.contains(changed))
+		return 0;
+	if (changed == m_goal) {
+		compute(labyrinth, m_goal);
+		m_lastRepairedCount = labyrinth.cellCount();
+		return m_lastRepairedCount;
+	}
+	size_t cell(index(changed));
+	if (labyrinth.at(cell) == wall)
+		repairAdded(labyrinth, cell);
+	else
+		repairRemoved(labyrinth, cell);
+
+	while (!m_layerSizes.empty() && m_layerSizes.back() == 0)
+		m_layerSizes.pop_back();
+	m_maxDistance = m_layerSizes.empty() ? 0 : (uint32_t)(m_layerSizes.size() - 1);
+	return m_lastRepairedCount;
+}
+
+/**
+* Repair, wall added
+*
+*	First the cells that lost every neighbour one step closer to the goal are found, layer by
+*	layer from the new wall, and made unreachable. Then they get their distance back from their
+*	intact neighbours, in increasing order, like a Dijkstra search limited to them.
+*/
+void DistanceField::repairAdded(const Grid& labyrinth, size_t index) {
+	uint32_t wallDistance(at(index));
+	if (wallDistance == unreachable)
+		return;
+	assign(index, unreachable);
+	m_lastRepairedCount = 1;
+
+	const ptrdiff_t offsets[4] = { -(ptrdiff_t)m_stride, (ptrdiff_t)m_stride, -1, 1 };
+	m_repairQueue.clear();
+	m_lostCells.clear();
+	for (int dir(0); dir < 4; ++dir)
+		if (at(index + offsets[dir]) == wallDistance + 1)
+			m_repairQueue.push_back(index + offsets[dir]);
+	for (size_t i(0); i < m_repairQueue.size(); ++i) {
+		size_t cell(m_repairQueue[i]);
+		uint32_t distance(at(cell));
+		if (distance == unreachable)	// Already lost
+			continue;
+		bool supported(false);
+		for (int dir(0); dir < 4 && !supported; ++dir)
+			supported = at(cell + offsets[dir]) == distance - 1;
+		if (supported)
+			continue;
+		assign(cell, unreachable);
+		m_lostCells.push_back(cell);
+		for (int dir(0); dir < 4; ++dir)
+			if (at(cell + offsets[dir]) == distance + 1)
+				m_repairQueue.push_back(cell + offsets[dir]);
+	}
+	m_lastRepairedCount += m_lostCells.size();
+
+	m_repairHeap.clear();
+	for (size_t cell : m_lostCells) {
+		uint32_t distance(bestNeighbour(labyrinth, cell));
+		if (distance != unreachable)
+			m_repairHeap.push_back(std::make_pair(distance, cell));
+	}
+	std::make_heap(m_repairHeap.begin(), m_repairHeap.end(), std::greater<std::pair<uint32_t, size_t>>());
+	while (!m_repairHeap.empty()) {
+		std::pop_heap(m_repairHeap.begin(), m_repairHeap.end(), std::greater<std::pair<uint32_t, size_t>>());
+		uint32_t distance(m_repairHeap.back().first);
+		size_t cell(m_repairHeap.back().second);
+		m_repairHeap.pop_back();
+		if (at(cell) <= distance)
+			continue;
+		assign(cell, distance);
+		for (int dir(0); dir < 4; ++dir) {
+			size_t neighbour(cell + offsets[dir]);
+			if (labyrinth.at(neighbour) != wall && at(neighbour) > distance + 1) {
+				m_repairHeap.push_back(std::make_pair(distance + 1, neighbour));
+				std::push_heap(m_repairHeap.begin(), m_repairHeap.end(), std::greater<std::pair<uint32_t, size_t>>());
+			}
+		}
+	}
+}
+
+/**
+* Repair, wall removed
+*
+*	Breadth-first search from the new free cell, through the cells it brings closer to the goal
+*/
+void DistanceField::repairRemoved(const Grid& labyrinth, size_t index) {
+	uint32_t distance(bestNeighbour(labyrinth, index));
+	if (distance == unreachable)
+		return;
+	const ptrdiff_t offsets[4] = { -(ptrdiff_t)m_stride, (ptrdiff_t)m_stride, -1, 1 };
+	assign(index, distance);
+	m_repairQueue.assign(1, index);
+	for (size_t i(0); i < m_repairQueue.size(); ++i) {
+		size_t cell(m_repairQueue[i]);
+		uint32_t next(at(cell) + 1);
+		for (int dir(0); dir < 4; ++dir) {
+			size_t neighbour(cell + offsets[dir]);
+			if (labyrinth.at(neighbour) != wall && at(neighbour) > next) {
+				assign(neighbour, next);
+				m_repairQueue.push_back(neighbour);
+			}
+		}
+	}
+	m_lastRepairedCount = m_repairQueue.size();
+}
+
+uint32_t DistanceField::bestNeighbour(const Grid& labyrinth, size_t index) const {
+	uint32_t best(unreachable);
+	for (int dir(up); dir <= right; ++dir) {
+		size_t neighbour(index + Grid::offset((Directions)dir, m_stride));
+		if (labyrinth.at(neighbour) != wall && at(neighbour) < best)
+			best = at(neighbour);
+	}
+	return best == unreachable ? unreachable : best + 1;
+}
+
+void DistanceField::assign(size_t index, uint32_t distance) {
+	uint32_t old(at(index));
+	if (old != unreachable)
+		--m_layerSizes[old];
+	else
+		++m_reachableCount;
+	if (distance != unreachable) {
+		if (distance >= m_layerSizes.size())
+			m_layerSizes.resize(distance + 1, 0);
+		++m_layerSizes[distance];
+	}
+	else
+		--m_reachableCount;
+
+	if (m_wide)
+		m_long[index] = distance;
+	else
+		m_short[index] = distance == unreachable ? shortUnreachable : (uint16_t)distance;
+}
+
+uint32_t DistanceField::get(Position at) const {
+	if (isEmpty() || at.x < 0 || at.x >= m_sizeX || at.y < 0 || at.y >= m_sizeY)
+		return unreachable;
+	return this->at(index(at));
+}
+
+/**
+* Towards goal
+*
+*	Constant time: looks at the 4 neighbours only.
+*	index: the Grid index of the current cell
+*	surroundings: its free neighbours
+*/
+Directions DistanceField::towardsGoal(size_t index, Surroundings surroundings) const {
+	Directions best(none);
+	uint32_t bestDistance(at(index));
+	for (int dir(up); dir <= right; ++dir) {
+		if (!surroundings.isOpen((Directions)dir))
+			continue;
+		uint32_t distance(at(index + Grid::offset((Directions)dir, m_stride)));
+		if (distance < bestDistance) {
+			best = (Directions)dir;
+			bestDistance = distance;
+		}
+	}
+	return best;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "../Engine/ThreadPool.h"
+#include "BitboardSearch.h"
+
+namespace Labyrinth {
+	/**
+	* Distance field
+	*
+	*	Number of moves from every cell to a goal cell, computed once by a breadth-first
+	*	search from the goal. Uses the padded layout of Grid, so a cell has the same index
+	*	in both. Distances are stored on 16 bits when the labyrinth is small enough
+	*	(fewer than 65535 playable cells), on 32 bits otherwise.
+	*	The search either walks a queue of cells or grows bitboard layers (BitboardSearch),
+	*	both give the same distances. Given a thread pool, the queue search expands each large
+	*	layer on all the workers, with the same result as on one thread.
+	*	After a cell of the labyrinth changed, repair() fixes the field in place, touching only
+	*	the cells whose distance changed and their neighbours (as LPA* / D* Lite do).
+	*/
+	class DistanceField {
+	public:
+		static const uint32_t unreachable = 0xFFFFFFFF;	/// Distance of walls and of cells cut from the goal
+
+		typedef enum SearchMethod_t {
+			queueSearch,	/// One cell at a time, reads the cell bytes
+			bitboardSearch	/// 64 cells at a time, reads the wall bitmap
+		} SearchMethod;
+
+		DistanceField();
+
+		void compute(const Grid& labyrinth, Position goal, SearchMethod method = queueSearch, ThreadPool* threadPool = nullptr);	/// Breadth-first search from goal over the free cells
+		size_t repair(const Grid& labyrinth, Position changed);	/// changed became a wall or free: update the distances, returns the number of cells changed
+		void clear();
+
+		uint32_t at(size_t index) const {	/// Unchecked read by Grid index
+			if (m_wide)
+				return m_long[index];
+			return m_short[index] == shortUnreachable ? unreachable : m_short[index];
+		}
+		uint32_t get(Position at) const;	/// Checked read, unreachable outside of the labyrinth
+		size_t index(Position at) const { return (size_t)(at.y + 1) * m_stride + (size_t)(at.x + 1); }	/// Same as Grid::index
+
+		Directions towardsGoal(size_t index, Surroundings surroundings) const;	/// The free direction with the lowest distance (none at the goal or if cut from it)
+
+		bool isEmpty() const { return m_short.empty() && m_long.empty(); }
+		bool isWide() const { return m_wide; }	/// Distances stored on 32 bits
+		Position getGoal() const { return m_goal; }
+		uint32_t getMaxDistance() const { return m_maxDistance; }	/// The farthest reachable cell
+		size_t getReachableCount() const { return m_reachableCount; }	/// Number of cells that can reach the goal, the goal included
+		size_t memoryBytes() const { return m_short.size() * sizeof(uint16_t) + m_long.size() * sizeof(uint32_t); }
+		size_t getLastRepairedCount() const { return m_lastRepairedCount; }	/// Cells changed by the last repair()
+
+	private:
+		static const uint16_t shortUnreachable = 0xFFFF;
+		static const size_t cellsPerChunk = 4096;	/// Parallel grain, smaller layers are expanded by the calling thread
+
+		template <typename T>
+		void search(const Grid& labyrinth, std::vector<T>& distances, T sentinel, SearchMethod method, ThreadPool* threadPool);
+		template <typename T>
+		void queueFill(const Grid& labyrinth, std::vector<T>& distances);
+		template <typename T>
+		void bitboardFill(const Grid& labyrinth, std::vector<T>& distances);
+		template <typename T>
+		void parallelFill(const Grid& labyrinth, std::vector<T>& distances, ThreadPool& threadPool);
+		void assign(size_t index, uint32_t distance);	/// Write a distance and keep the layer sizes up to date
+		uint32_t bestNeighbour(const Grid& labyrinth, size_t index) const;	/// 1 + the lowest distance of the free neighbours
+		void repairAdded(const Grid& labyrinth, size_t index);
+		void repairRemoved(const Grid& labyrinth, size_t index);
+
+		bool m_wide;
+		std::vector<uint16_t> m_short;	/// Distances when !m_wide
+		std::vector<uint32_t> m_long;	/// Distances when m_wide
+		size_t m_stride;	/// Row length of the padded layout
+		int m_sizeX;
+		int m_sizeY;
+		Position m_goal;
+		uint32_t m_maxDistance;
+		size_t m_reachableCount;
+		std::vector<size_t> m_layerSizes;	/// Number of cells at each distance, keeps m_maxDistance exact through the repairs
+		BitboardSearch m_bitboard;	/// Kept to reuse its buffers from one computation to the next
+
+		// Parallel search
+		std::unique_ptr<std::atomic<uint64_t>[]> m_claimed;	/// 1 bit per cell index: walls and reached cells
+		size_t m_claimedWords;
+		std::vector<std::vector<size_t>> m_chunkFrontiers;	/// Next layer found by each chunk of the current one
+
+		// Repair
+		size_t m_lastRepairedCount;
+		std::vector<size_t> m_repairQueue;	/// Cells to look at, in distance order
+		std::vector<size_t> m_lostCells;	/// Cells cut from their shortest path by a new wall
+		std::vector<std::pair<uint32_t, size_t>> m_repairHeap;	/// Distance and cell (apart: the cell indices can pass 2^32), the lowest on top
+	};
+}
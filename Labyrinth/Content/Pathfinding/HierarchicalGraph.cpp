@@ -0,0 +1,331 @@
+#include "HierarchicalGraph.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace Labyrinth;
+
+const uint32_t HierarchicalGraph::none;
+
+namespace {
+	/**
+	* Tile search
+	*
+	*	Breadth-first search restricted to a rectangle of the labyrinth
+	*/
+	struct TileSearch {
+		int x0, y0, width, height;
+		std::vector<uint32_t> distances;	/// One per cell of the rectangle, row-major
+		std::vector<uint32_t> queue;
+
+		void run(const Grid& labyrinth, int x, int y, int w, int h, size_t start) {
+			x0 = x;
+			y0 = y;
+			width = w;
+			height = h;
+			distances.assign((size_t)w * h, HierarchicalGraph::none);
+			queue.clear();
+			Position origin(labyrinth.position(start));
+			uint32_t first((uint32_t)((origin.y - y0) * width + origin.x - x0));
+			distances[first] = 0;
+			queue.push_back(first);
+			const uint8_t* corner = labyrinth.cells() + labyrinth.index(Position(x0, y0));
+			size_t stride(labyrinth.stride());
+			for (size_t head(0); head < queue.size(); ++head) {
+				uint32_t local(queue[head]);
+				int cx((int)(local % width)), cy((int)(local / width));
+				const uint8_t* cell = corner + cy * stride + cx;
+				uint32_t next(distances[local] + 1);
+				if (cy > 0 && cell[-(ptrdiff_t)stride] != wall)
+					visit(local - width, next);
+				if (cy + 1 < height && cell[stride] != wall)
+					visit(local + width, next);
+				if (cx > 0 && cell[-1] != wall)
+					visit(local - 1, next);
+				if (cx + 1 < width && cell[1] != wall)
+					visit(local + 1, next);
+			}
+		}
+
+		void visit(uint32_t local, uint32_t distance) {
+			if (distances[local] == HierarchicalGraph::none) {
+				distances[local] = distance;
+				queue.push_back(local);
+			}
+		}
+
+		uint32_t at(const Grid& labyrinth, size_t cell) const {	/// Distance to a Grid index inside the rectangle
+			Position p(labyrinth.position(cell));
+			return distances[(size_t)(p.y - y0) * width + (p.x - x0)];
+		}
+	};
+
+	/**
+	* Local searches
+	*
+	*	Scratch searches of the calling thread: the tile of the start and the tile of the goal
+	*/
+	TileSearch* localSearches() {
+		static thread_local TileSearch searches[2];
+		return searches;
+	}
+}
+
+HierarchicalGraph::HierarchicalGraph() :
+	m_tileSize(32),
+	m_tilesX(0),
+	m_tilesY(0),
+	m_stride(0),
+	m_sizeX(0),
+	m_sizeY(0),
+	m_lastRebuiltTiles(0) {
+}
+
+/**
+* Build
+*
+*	Every tile only reads the labyrinth and writes itself, so they are built in parallel
+*	tileSize: the side of the tiles in cells
+*/
+void HierarchicalGraph::build(const Grid& labyrinth, int tileSize, ThreadPool* threadPool) {
+	m_tileSize = tileSize > 1 ? tileSize : 2;
+	m_stride = labyrinth.stride();
+	m_sizeX = labyrinth.sizeX();
+	m_sizeY = labyrinth.sizeY();
+	m_tilesX = (m_sizeX + m_tileSize - 1) / m_tileSize;
+	m_tilesY = (m_sizeY + m_tileSize - 1) / m_tileSize;
+	m_tiles.assign((size_t)m_tilesX * m_tilesY, Tile());
+
+	auto buildTiles = [this, &labyrinth](size_t first, size_t last) {
+		for (size_t tile(first); tile < last; ++tile)
+			buildTile(labyrinth, tile);
+	};
+	if (threadPool != nullptr)
+		threadPool->parallelFor(m_tiles.size(), 16, buildTiles);
+	else
+		buildTiles(0, m_tiles.size());
+	indexNodes();
+	m_lastRebuiltTiles = m_tiles.size();
+}
+
+/**
+* Update
+*
+*	The tile of the cell gets new inside distances; if the cell lies on a tile border,
+*	the entrances of that border change on both sides, so the tiles across are rebuilt too
+*/
+void HierarchicalGraph::update(const Grid& labyrinth, Position cell) {
+	if (m_tiles.empty() || !labyrinth.contains(cell))
+		return;
+	int tx(cell.x / m_tileSize), ty(cell.y / m_tileSize);
+	int dxs[3] = { 0, 0, 0 }, dys[3] = { 0, 0, 0 };
+	int countX(1), countY(1);
+	if (cell.x % m_tileSize == 0 && tx > 0)
+		dxs[countX++] = -1;
+	if (cell.x % m_tileSize == m_tileSize - 1 && tx + 1 < m_tilesX)
+		dxs[countX++] = 1;
+	if (cell.y % m_tileSize == 0 && ty > 0)
+		dys[countY++] = -1;
+	if (cell.y % m_tileSize == m_tileSize - 1 && ty + 1 < m_tilesY)
+		dys[countY++] = 1;
+
+	// The tile itself and the tiles sharing a border with the cell (not the diagonal ones)
+	m_lastRebuiltTiles = 0;
+	for (int i(0); i < countX; ++i) {
+		buildTile(labyrinth, (size_t)ty * m_tilesX + tx + dxs[i]);
+		++m_lastRebuiltTiles;
+	}
+	for (int i(1); i < countY; ++i) {
+		buildTile(labyrinth, (size_t)(ty + dys[i]) * m_tilesX + tx);
+		++m_lastRebuiltTiles;
+	}
+	indexNodes();
+}
+
+void HierarchicalGraph::clear() {
+	std::vector<Tile>().swap(m_tiles);
+	std::vector<uint32_t>().swap(m_firstNode);
+	std::vector<uint32_t>().swap(m_nodeCells);
+	std::vector<uint32_t>().swap(m_nodeTiles);
+	m_tilesX = m_tilesY = 0;
+}
+
+/**
+* Build tile
+*
+*	Finds the entrances on the 4 sides, then one search inside the tile from each of them
+*/
+void HierarchicalGraph::buildTile(const Grid& labyrinth, size_t index) {
+	Tile& tile = m_tiles[index];
+	tile.nodes.clear();
+	int x0((int)(index % m_tilesX) * m_tileSize), y0((int)(index / m_tilesX) * m_tileSize);
+	int width(std::min(m_tileSize, m_sizeX - x0)), height(std::min(m_tileSize, m_sizeY - y0));
+
+	addEntrances(labyrinth, index, x0, y0, 0, 1, height, -1, 0);	// Left
+	addEntrances(labyrinth, index, x0 + width - 1, y0, 0, 1, height, 1, 0);	// Right
+	addEntrances(labyrinth, index, x0, y0, 1, 0, width, 0, -1);	// Top
+	addEntrances(labyrinth, index, x0, y0 + height - 1, 1, 0, width, 0, 1);	// Bottom
+	std::sort(tile.nodes.begin(), tile.nodes.end());
+	tile.nodes.erase(std::unique(tile.nodes.begin(), tile.nodes.end()), tile.nodes.end());
+
+	size_t count(tile.nodes.size());
+	tile.distances.assign(count * count, none);
+	TileSearch search;
+	for (size_t i(0); i < count; ++i) {
+		search.run(labyrinth, x0, y0, width, height, tile.nodes[i]);
+		for (size_t j(0); j < count; ++j)
+			tile.distances[i * count + j] = search.at(labyrinth, tile.nodes[j]);
+	}
+}
+
+/**
+* Add entrances
+*
+*	Scans the length cells of a side, from (x;y) by (stepX;stepY). A run of cells that are free
+*	on both sides of the border gets one entrance in its middle, or one at each end when it
+*	is longer than 5 cells. The tile across scans the same cells, so both sides agree.
+*	outsideX, outsideY: from a side cell to the cell across the border
+*/
+void HierarchicalGraph::addEntrances(const Grid& labyrinth, size_t tile, int x, int y, int stepX, int stepY, int length, int outsideX, int outsideY) {
+	if (!labyrinth.contains(Position(x + outsideX, y + outsideY)))
+		return;	// The labyrinth border
+	std::vector<uint32_t>& nodes = m_tiles[tile].nodes;
+	int runStart(-1);
+	for (int i(0); i <= length; ++i) {
+		Position inside(x + i * stepX, y + i * stepY);
+		bool open(i < length && labyrinth.get(inside) != wall && labyrinth.get(Position(inside.x + outsideX, inside.y + outsideY)) != wall);
+		if (open && runStart < 0)
+			runStart = i;
+		else if (!open && runStart >= 0) {
+			int runEnd(i - 1);
+			if (runEnd - runStart + 1 <= 5) {
+				int middle((runStart + runEnd) / 2);
+				nodes.push_back((uint32_t)labyrinth.index(Position(x + middle * stepX, y + middle * stepY)));
+			}
+			else {
+				nodes.push_back((uint32_t)labyrinth.index(Position(x + runStart * stepX, y + runStart * stepY)));
+				nodes.push_back((uint32_t)labyrinth.index(Position(x + runEnd * stepX, y + runEnd * stepY)));
+			}
+			runStart = -1;
+		}
+	}
+}
+
+void HierarchicalGraph::indexNodes() {
+	m_firstNode.resize(m_tiles.size() + 1);
+	m_nodeCells.clear();
+	m_nodeTiles.clear();
+	for (size_t tile(0); tile < m_tiles.size(); ++tile) {
+		m_firstNode[tile] = (uint32_t)m_nodeCells.size();
+		m_nodeCells.insert(m_nodeCells.end(), m_tiles[tile].nodes.begin(), m_tiles[tile].nodes.end());
+		m_nodeTiles.resize(m_nodeCells.size(), (uint32_t)tile);
+	}
+	m_firstNode[m_tiles.size()] = (uint32_t)m_nodeCells.size();
+}
+
+size_t HierarchicalGraph::tileOf(size_t cell) const {
+	int x((int)(cell % m_stride) - 1), y((int)(cell / m_stride) - 1);
+	return (size_t)(y / m_tileSize) * m_tilesX + x / m_tileSize;
+}
+
+uint32_t HierarchicalGraph::nodeAt(size_t tile, size_t cell) const {
+	const std::vector<uint32_t>& nodes = m_tiles[tile].nodes;
+	std::vector<uint32_t>::const_iterator found(std::lower_bound(nodes.begin(), nodes.end(), (uint32_t)cell));
+	if (found == nodes.end() || *found != cell)
+		return none;
+	return m_firstNode[tile] + (uint32_t)(found - nodes.begin());
+}
+
+/**
+* Find path
+*
+*	A* over the entrances, with two extra nodes: the start (linked to the entrances of its tile)
+*	and the goal (linked from the entrances of its tile, or straight from the start in the same tile).
+*	Refine two consecutive waypoints with AStar::findPath: they are joined inside a tile or
+*	by one move across a border.
+*	arena: working memory (SearchArena::local() for the calling thread)
+*/
+bool HierarchicalGraph::findPath(const Grid& labyrinth, Position from, Position to, std::vector<uint32_t>& waypoints, SearchArena& arena) const {
+	waypoints.clear();
+	if (m_tiles.empty() || labyrinth.get(from) == wall || labyrinth.get(to) == wall)
+		return false;
+	if (from == to)
+		return true;
+
+	size_t startCell(labyrinth.index(from)), goalCell(labyrinth.index(to));
+	size_t startTile(tileOf(startCell)), goalTile(tileOf(goalCell));
+	TileSearch* searches = localSearches();
+	TileSearch& startSearch = searches[0];
+	TileSearch& goalSearch = searches[1];
+	auto searchTile = [this, &labyrinth](TileSearch& search, size_t tile, size_t cell) {
+		int x0((int)(tile % m_tilesX) * m_tileSize), y0((int)(tile / m_tilesX) * m_tileSize);
+		search.run(labyrinth, x0, y0, std::min(m_tileSize, m_sizeX - x0), std::min(m_tileSize, m_sizeY - y0), cell);
+	};
+	searchTile(startSearch, startTile, startCell);
+	searchTile(goalSearch, goalTile, goalCell);
+
+	uint32_t start((uint32_t)m_nodeCells.size()), goal(start + 1);
+	auto heuristic = [this, to](uint32_t node) {
+		int x((int)(m_nodeCells[node] % m_stride) - 1), y((int)(m_nodeCells[node] / m_stride) - 1);
+		return (uint32_t)(std::abs(x - to.x) + std::abs(y - to.y));
+	};
+	auto relax = [&arena, &heuristic, goal](uint32_t node, uint32_t cost, uint32_t parent) {
+		if (!arena.isClosed(node) && (!arena.isSeen(node) || cost < arena.getCost(node)))
+			arena.open(node, cost, parent, node == goal ? 0 : heuristic(node));
+	};
+
+	arena.reset(m_nodeCells.size() + 2);
+	for (uint32_t node(m_firstNode[startTile]); node < m_firstNode[startTile + 1]; ++node) {
+		uint32_t distance(startSearch.at(labyrinth, m_nodeCells[node]));
+		if (distance != none)
+			relax(node, distance, start);
+	}
+	if (startTile == goalTile && startSearch.at(labyrinth, goalCell) != none)
+		relax(goal, startSearch.at(labyrinth, goalCell), start);
+
+	SearchArena::OpenNode open;
+	while (arena.popOpen(open)) {
+		uint32_t node(open.cell);
+		if (node == goal) {
+			for (uint32_t step(arena.getParent(goal)); step != start; step = arena.getParent(step))
+				waypoints.push_back(m_nodeCells[step]);
+			std::reverse(waypoints.begin(), waypoints.end());
+			waypoints.push_back((uint32_t)goalCell);
+			return true;
+		}
+		arena.close(node);
+
+		size_t tile(m_nodeTiles[node]), cell(m_nodeCells[node]);
+		if (tile == goalTile) {
+			uint32_t distance(goalSearch.at(labyrinth, cell));
+			if (distance != none)
+				relax(goal, open.cost + distance, node);
+		}
+		// Inside the tile
+		uint32_t first(m_firstNode[tile]), count(m_firstNode[tile + 1] - first);
+		const uint32_t* distances = &m_tiles[tile].distances[(size_t)(node - first) * count];
+		for (uint32_t other(0); other < count; ++other)
+			if (distances[other] != none && other != node - first)
+				relax(first + other, open.cost + distances[other], node);
+		// Across the borders
+		for (int dir(up); dir <= right; ++dir) {
+			size_t neighbour(cell + labyrinth.offset((Directions)dir));
+			if (labyrinth.at(neighbour) == wall || !labyrinth.contains(labyrinth.position(neighbour)))
+				continue;
+			size_t neighbourTile(tileOf(neighbour));
+			if (neighbourTile == tile)
+				continue;
+			uint32_t across(nodeAt(neighbourTile, neighbour));
+			if (across != none)
+				relax(across, open.cost + 1, node);
+		}
+	}
+	return false;
+}
+
+size_t HierarchicalGraph::memoryBytes() const {
+	size_t bytes(m_tiles.capacity() * sizeof(Tile) + (m_firstNode.capacity() + m_nodeCells.capacity() + m_nodeTiles.capacity()) * sizeof(uint32_t));
+	for (const Tile& tile : m_tiles)
+		bytes += (tile.nodes.capacity() + tile.distances.capacity()) * sizeof(uint32_t);
+	return bytes;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "../Engine/ThreadPool.h"
+#include "SearchArena.h"
+
+namespace Labyrinth {
+	/**
+	* Hierarchical graph
+	*
+	*	HPA*: the labyrinth is cut in square tiles. Where two tiles share a run of free cells on
+	*	their border, entrance nodes are placed on both sides (one pair in the middle of a short
+	*	run, one at each end of a long one). Inside a tile, the distances between its entrances
+	*	are precomputed. A query searches this abstract graph (start and goal are linked to the
+	*	entrances of their tiles by a search inside the tile) and returns the entrances the path
+	*	goes through; the moves between two of them are found later, when they are needed.
+	*	The paths are close to optimal, not always optimal.
+	*	The tiles are built independently (in parallel given a thread pool), and a changed cell
+	*	only rebuilds the tiles whose entrances or inside it can affect.
+	*/
+	class HierarchicalGraph {
+	public:
+		static const uint32_t none = 0xFFFFFFFF;	/// No path inside a tile
+
+		HierarchicalGraph();
+
+		void build(const Grid& labyrinth, int tileSize = 32, ThreadPool* threadPool = nullptr);	/// Cut the labyrinth in tiles and build all of them
+		void update(const Grid& labyrinth, Position cell);	/// A cell changed: rebuild the tiles it belongs to or borders
+		void clear();
+
+		bool findPath(const Grid& labyrinth, Position from, Position to, std::vector<uint32_t>& waypoints, SearchArena& arena) const;	/// waypoints: Grid indices of the entrances on the way, the goal last (empty if from is to)
+
+		bool isEmpty() const { return m_tiles.empty(); }
+		int getTileSize() const { return m_tileSize; }
+		size_t tileCount() const { return m_tiles.size(); }
+		size_t nodeCount() const { return m_nodeCells.size(); }
+		size_t getLastRebuiltTiles() const { return m_lastRebuiltTiles; }	/// Tiles rebuilt by the last build() or update()
+		size_t memoryBytes() const;
+
+	private:
+		/**
+		* Tile
+		*
+		*	The entrances of a tile and the distances between them
+		*/
+		struct Tile {
+			std::vector<uint32_t> nodes;	/// Grid indices of the entrances, sorted
+			std::vector<uint32_t> distances;	/// nodes.size()^2 distances inside the tile, none if cut
+		};
+
+		void buildTile(const Grid& labyrinth, size_t tile);
+		void addEntrances(const Grid& labyrinth, size_t tile, int x, int y, int stepX, int stepY, int length, int outsideX, int outsideY);	/// The entrances of one side
+		void indexNodes();	/// Global node numbering, after any tile change
+		size_t tileOf(size_t cell) const;	/// The tile of a Grid index
+		uint32_t nodeAt(size_t tile, size_t cell) const;	/// Global id of the entrance of a tile on a cell, none if it is not one
+
+		int m_tileSize;
+		int m_tilesX;	/// Tiles per row
+		int m_tilesY;
+		size_t m_stride;
+		int m_sizeX;
+		int m_sizeY;
+		std::vector<Tile> m_tiles;	/// Row-major
+		std::vector<uint32_t> m_firstNode;	/// Global id of the first entrance of each tile (tile count + 1)
+		std::vector<uint32_t> m_nodeCells;	/// Grid index of each global node
+		std::vector<uint32_t> m_nodeTiles;	/// Tile of each global node
+		size_t m_lastRebuiltTiles;
+	};
+}
@@ -0,0 +1,215 @@
+#include "JunctionGraph.h"
+
+using namespace Labyrinth;
+
+JunctionGraph::JunctionGraph() :
+	m_stride(0),
+	m_sizeX(0),
+	m_sizeY(0) {
+}
+
+/**
+* Build
+*
+*	One pass to number the nodes, one walk along each corridor from each of its ends:
+*	linear in the number of cells
+*/
+void JunctionGraph::build(const Grid& labyrinth) {
+	clear();
+	m_stride = labyrinth.stride();
+	m_sizeX = labyrinth.sizeX();
+	m_sizeY = labyrinth.sizeY();
+	Location wallLocation;
+	wallLocation.id = none;
+	wallLocation.offset = 0;
+	m_cells.assign(labyrinth.cellCount(), wallLocation);
+
+	// Nodes: the free cells that are not in the middle of a corridor
+	for (int y(0); y < m_sizeY; ++y) {
+		size_t index(labyrinth.index(Position(0, y)));
+		for (int x(0); x < m_sizeX; ++x, ++index) {
+			if (labyrinth.at(index) != wall && labyrinth.surroundings(index).count() != 2) {
+				m_cells[index].id = (uint32_t)m_nodeCells.size();
+				m_nodeCells.push_back((uint32_t)index);
+			}
+		}
+	}
+
+	for (uint32_t node(0); node < (uint32_t)m_nodeCells.size(); ++node)
+		for (int dir(up); dir <= right; ++dir)
+			follow(labyrinth, node, (Directions)dir);
+
+	// Corridors closed on themselves: none of their cells has been reached
+	for (int y(0); y < m_sizeY; ++y) {
+		size_t index(labyrinth.index(Position(0, y)));
+		for (int x(0); x < m_sizeX; ++x, ++index) {
+			if (labyrinth.at(index) != wall && m_cells[index].id == none) {
+				uint32_t node((uint32_t)m_nodeCells.size());
+				m_cells[index].id = node;
+				m_nodeCells.push_back((uint32_t)index);
+				for (int dir(up); dir <= right; ++dir)
+					follow(labyrinth, node, (Directions)dir);
+			}
+		}
+	}
+
+	// Adjacency lists: count the links of every node, then fill them
+	m_firstLink.assign(m_nodeCells.size() + 1, 0);
+	for (const Edge& edge : m_edges) {
+		++m_firstLink[edge.from + 1];
+		++m_firstLink[edge.to + 1];
+	}
+	for (size_t node(0); node < m_nodeCells.size(); ++node)
+		m_firstLink[node + 1] += m_firstLink[node];
+	m_links.resize(m_firstLink.back());
+	std::vector<uint32_t> filled(m_firstLink.begin(), m_firstLink.end() - 1);
+	for (uint32_t id(0); id < (uint32_t)m_edges.size(); ++id) {
+		const Edge& edge = m_edges[id];
+		Link link;
+		link.edge = id;
+		link.node = edge.to;
+		m_links[filled[edge.from]++] = link;
+		link.node = edge.from;
+		m_links[filled[edge.to]++] = link;
+	}
+	std::vector<uint32_t>().swap(m_corridor);
+}
+
+void JunctionGraph::clear() {
+	std::vector<Location>().swap(m_cells);
+	std::vector<uint32_t>().swap(m_nodeCells);
+	std::vector<Edge>().swap(m_edges);
+	std::vector<uint32_t>().swap(m_firstCorridorCell);
+	std::vector<uint32_t>().swap(m_corridorCells);
+	std::vector<uint32_t>().swap(m_firstLink);
+	std::vector<Link>().swap(m_links);
+}
+
+/**
+* Follow
+*
+*	Walks from a node through a free neighbour until the next node. A corridor is walked once
+*	from each end: the end with the lowest (node, direction) pair creates the edge, so every
+*	corridor (loops included) becomes exactly one edge.
+*/
+void JunctionGraph::follow(const Grid& labyrinth, uint32_t node, Directions dir) {
+	size_t previous(m_nodeCells[node]);
+	size_t cell(previous + labyrinth.offset(dir));
+	if (labyrinth.at(cell) == wall)
+		return;
+
+	m_corridor.clear();
+	Directions last(dir);
+	while (!m_cells[cell].isNode()) {
+		if (m_cells[cell].isEdge())
+			return;	// Already created from its other end
+		m_corridor.push_back((uint32_t)cell);
+		// On to the one free neighbour that is not where we come from
+		Surroundings surroundings(labyrinth.surroundings(cell));
+		for (int next(up); next <= right; ++next) {
+			size_t neighbour(cell + labyrinth.offset((Directions)next));
+			if (surroundings.isOpen((Directions)next) && neighbour != previous) {
+				previous = cell;
+				cell = neighbour;
+				last = (Directions)next;
+				break;
+			}
+		}
+	}
+
+	// Arrived at a node, by the side opposite to last
+	uint32_t other(m_cells[cell].id);
+	Directions back(last == up ? down : last == down ? up : last == left ? right : left);
+	if ((uint64_t)other * 4 + back < (uint64_t)node * 4 + dir)
+		return;	// The other end creates it
+
+	uint32_t id((uint32_t)m_edges.size());
+	Edge edge;
+	edge.from = node;
+	edge.to = other;
+	edge.length = (uint32_t)m_corridor.size() + 1;
+	m_edges.push_back(edge);
+	m_firstCorridorCell.push_back((uint32_t)m_corridorCells.size());
+	for (uint32_t i(0); i < (uint32_t)m_corridor.size(); ++i) {
+		m_cells[m_corridor[i]].id = id;
+		m_cells[m_corridor[i]].offset = i + 1;
+	}
+	m_corridorCells.insert(m_corridorCells.end(), m_corridor.begin(), m_corridor.end());
+}
+
+Position JunctionGraph::nodePosition(size_t node) const {
+	return position(m_nodeCells[node]);
+}
+
+JunctionGraph::Location JunctionGraph::locate(Position at) const {
+	if (m_cells.empty() || at.x < 0 || at.x >= m_sizeX || at.y < 0 || at.y >= m_sizeY) {
+		Location outside;
+		outside.id = none;
+		outside.offset = 0;
+		return outside;
+	}
+	return m_cells[(size_t)(at.y + 1) * m_stride + (size_t)(at.x + 1)];
+}
+
+Position JunctionGraph::cellAt(size_t edge, uint32_t offset) const {
+	const Edge& e = m_edges[edge];
+	if (offset == 0)
+		return nodePosition(e.from);
+	if (offset >= e.length)
+		return nodePosition(e.to);
+	return position(m_corridorCells[m_firstCorridorCell[edge] + offset - 1]);
+}
+
+/**
+* Distance
+*
+*	Dijkstra over the nodes. A cell inside a corridor enters the graph through both ends of
+*	its edge; the goal cell is an extra node (index nodeCount()) reached the same way.
+*	arena: working memory (SearchArena::local() for the calling thread)
+*/
+uint32_t JunctionGraph::distance(Position from, Position to, SearchArena& arena) const {
+	Location source(locate(from)), target(locate(to));
+	if (source.id == none || target.id == none)
+		return none;
+	if (from == to)
+		return 0;
+
+	size_t goal(nodeCount());
+	arena.reset(goal + 1);
+	auto relax = [&arena](size_t node, uint32_t cost) {
+		if (!arena.isClosed(node) && (!arena.isSeen(node) || cost < arena.getCost(node)))
+			arena.open(node, cost, node, 0);
+	};
+	if (source.isNode())
+		relax(source.id, 0);
+	else {
+		const Edge& edge = m_edges[source.id];
+		relax(edge.from, source.offset);
+		relax(edge.to, edge.length - source.offset);
+		if (target.isEdge() && target.id == source.id)	// Straight along the shared corridor
+			relax(goal, source.offset > target.offset ? source.offset - target.offset : target.offset - source.offset);
+	}
+
+	SearchArena::OpenNode node;
+	while (arena.popOpen(node)) {
+		if (node.cell == goal || (target.isNode() && node.cell == target.id))
+			return node.cost;
+		arena.close(node.cell);
+		if (target.isEdge()) {
+			const Edge& edge = m_edges[target.id];
+			if (node.cell == edge.from)
+				relax(goal, node.cost + target.offset);
+			if (node.cell == edge.to)
+				relax(goal, node.cost + edge.length - target.offset);
+		}
+		for (const Link* link(linksBegin(node.cell)); link != linksEnd(node.cell); ++link)
+			relax(link->node, node.cost + m_edges[link->edge].length);
+	}
+	return none;
+}
+
+size_t JunctionGraph::memoryBytes() const {
+	return m_cells.capacity() * sizeof(Location) + (m_nodeCells.capacity() + m_firstCorridorCell.capacity()
+		+ m_corridorCells.capacity() + m_firstLink.capacity()) * sizeof(uint32_t)
+		+ m_edges.capacity() * sizeof(Edge) + m_links.capacity() * sizeof(Link);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "SearchArena.h"
+
+namespace Labyrinth {
+	/**
+	* Junction graph
+	*
+	*	The labyrinth with its corridors contracted: the nodes are the free cells that do not
+	*	have exactly 2 free neighbours (junctions, dead ends, isolated cells), the edges are the
+	*	corridors between them, weighted by their length in moves. A corridor closed on itself
+	*	gets one of its cells as a node.
+	*	Every free cell maps back to its node, or to its edge and its distance from the edge start,
+	*	so positions translate both ways and searches on the graph give grid distances.
+	*/
+	class JunctionGraph {
+	public:
+		static const uint32_t none = 0xFFFFFFFF;	/// No node, no edge, or no path
+
+		/**
+		* Edge
+		*
+		*	A corridor: length moves from the from node to the to node, length - 1 cells in between
+		*/
+		struct Edge {
+			uint32_t from;
+			uint32_t to;
+			uint32_t length;
+		};
+
+		/**
+		* Link
+		*
+		*	An edge seen from one of its nodes
+		*/
+		struct Link {
+			uint32_t edge;
+			uint32_t node;	/// The node at the other end
+		};
+
+		/**
+		* Location
+		*
+		*	Where a cell lies in the graph: a node (offset 0), or the cell offset moves from the start of an edge
+		*/
+		struct Location {
+			uint32_t id;	/// Node or edge index, none for a wall
+			uint32_t offset;
+
+			bool isNode() const { return offset == 0 && id != none; }
+			bool isEdge() const { return offset != 0; }
+		};
+
+		JunctionGraph();
+
+		void build(const Grid& labyrinth);	/// Contract the corridors of a labyrinth
+		void clear();
+
+		size_t nodeCount() const { return m_nodeCells.size(); }
+		size_t edgeCount() const { return m_edges.size(); }
+		const Edge& edge(size_t id) const { return m_edges[id]; }
+		const Link* linksBegin(size_t node) const { return m_links.data() + m_firstLink[node]; }	/// The edges of a node
+		const Link* linksEnd(size_t node) const { return m_links.data() + m_firstLink[node + 1]; }
+		Position nodePosition(size_t node) const;
+
+		Location locate(Position at) const;	/// The node or edge of a cell (id none for walls and outside cells)
+		Position cellAt(size_t edge, uint32_t offset) const;	/// The cell offset moves from the start of an edge (0 to length), inverse of locate()
+
+		uint32_t distance(Position from, Position to, SearchArena& arena) const;	/// Shortest path length in moves (Dijkstra on the graph), none if cut
+
+		size_t memoryBytes() const;
+
+	private:
+		void follow(const Grid& labyrinth, uint32_t node, Directions dir);	/// Walk a corridor from a node, keep it if this end creates it
+		Position position(size_t index) const { return Position((int)(index % m_stride) - 1, (int)(index / m_stride) - 1); }
+
+		size_t m_stride;	/// Row length of the padded Grid layout
+		int m_sizeX;
+		int m_sizeY;
+		std::vector<Location> m_cells;	/// One per Grid index
+		std::vector<uint32_t> m_nodeCells;	/// Grid index of each node
+		std::vector<Edge> m_edges;
+		std::vector<uint32_t> m_firstCorridorCell;	/// The cells of edge e: m_corridorCells[m_firstCorridorCell[e] + offset - 1]
+		std::vector<uint32_t> m_corridorCells;	/// Grid index of the cells inside the corridors, edge after edge
+		std::vector<uint32_t> m_firstLink;	/// Links of node n: [m_firstLink[n], m_firstLink[n + 1])
+		std::vector<Link> m_links;
+		std::vector<uint32_t> m_corridor;	/// Scratch: the cells of the corridor being walked
+	};
+}
@@ -0,0 +1,101 @@
+#include "Landmarks.h"
+
+using namespace Labyrinth;
+
+Landmarks::Landmarks() {
+}
+
+/**
+* Build
+*
+*	The first landmark is the cell the farthest from start, every next one the cell the farthest
+*	from its nearest landmark. Stops early when every reachable cell is a landmark.
+*	One breadth-first search per landmark (on the workers given a thread pool).
+*/
+void Landmarks::build(const Grid& labyrinth, size_t count, Position start, ThreadPool* threadPool) {
+	clear();
+	if (count == 0 || labyrinth.get(start) == wall)
+		return;
+
+	DistanceField probe;
+	probe.compute(labyrinth, start, DistanceField::queueSearch, threadPool);
+	std::vector<uint32_t> nearest(labyrinth.cellCount(), DistanceField::unreachable);
+	const DistanceField* last = &probe;
+	m_fields.reserve(count);
+	while (m_fields.size() < count) {
+		// The reachable cell the farthest from the closest landmark (from start for the first one)
+		size_t farthest(0);
+		uint32_t farthestDistance(0);
+		for (size_t cell(0); cell < nearest.size(); ++cell) {
+			uint32_t distance(last->at(cell));
+			if (distance == DistanceField::unreachable)
+				continue;
+			if (last != &probe && distance < nearest[cell])
+				nearest[cell] = distance;
+			uint32_t from(last == &probe ? distance : nearest[cell]);
+			if (from > farthestDistance) {
+				farthest = cell;
+				farthestDistance = from;
+			}
+		}
+		if (farthestDistance == 0)
+			break;
+
+		m_positions.push_back(labyrinth.position(farthest));
+		m_fields.push_back(DistanceField());
+		m_fields.back().compute(labyrinth, m_positions.back(), DistanceField::queueSearch, threadPool);
+		last = &m_fields.back();
+		if (m_fields.size() == 1)	// nearest starts from the first landmark
+			for (size_t cell(0); cell < nearest.size(); ++cell)
+				nearest[cell] = last->at(cell);
+	}
+}
+
+void Landmarks::repair(const Grid& labyrinth, Position changed) {
+	for (DistanceField& field : m_fields)
+		field.repair(labyrinth, changed);
+}
+
+void Landmarks::clear() {
+	std::vector<DistanceField>().swap(m_fields);
+	std::vector<Position>().swap(m_positions);
+}
+
+/**
+* Lower bound
+*
+*	Largest |d(L, from) - d(L, to)| over the landmarks, O(landmark count).
+*	A cell reached by a landmark and the other not means they are not connected.
+*/
+uint32_t Landmarks::lowerBound(size_t from, size_t to) const {
+	uint32_t bound(0);
+	for (const DistanceField& field : m_fields) {
+		uint32_t a(field.at(from)), b(field.at(to));
+		if (a == DistanceField::unreachable || b == DistanceField::unreachable) {
+			if (a != b)
+				return none;
+			continue;
+		}
+		uint32_t difference(a > b ? a - b : b - a);
+		if (difference > bound)
+			bound = difference;
+	}
+	return bound;
+}
+
+uint32_t Landmarks::lowerBound(Position from, Position to) const {
+	if (m_fields.empty())
+		return 0;
+	bool fromReached(m_fields.front().get(from) != DistanceField::unreachable);
+	bool toReached(m_fields.front().get(to) != DistanceField::unreachable);
+	if (!fromReached || !toReached)
+		return fromReached == toReached ? 0 : none;	// Both outside of the landmarks' part: no information
+	return lowerBound(m_fields.front().index(from), m_fields.front().index(to));
+}
+
+size_t Landmarks::memoryBytes() const {
+	size_t bytes(0);
+	for (const DistanceField& field : m_fields)
+		bytes += field.memoryBytes();
+	return bytes;
+}
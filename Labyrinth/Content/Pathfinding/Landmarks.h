@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.h"
+#include "../Maze/Grid.h"
+#include "../Engine/ThreadPool.h"
+#include "DistanceField.h"
+
+namespace Labyrinth {
+	/**
+	* Landmarks
+	*
+	*	ALT preprocessing: the distances from a few landmark cells to every cell. By the triangle
+	*	inequality, |d(L, a) - d(L, b)| never exceeds the distance between a and b: the largest
+	*	such difference is a lower bound, much closer to the real distance than the Manhattan
+	*	distance in a twisty labyrinth, and usable as an A* heuristic.
+	*	The landmarks are chosen by farthest-point selection: each one is the cell the farthest
+	*	from the ones already chosen. Each of them keeps a DistanceField (16 or 32 bits per cell).
+	*	The landmarks stay where they are when the labyrinth is edited, their distances are repaired.
+	*/
+	class Landmarks {
+	public:
+		static const uint32_t none = 0xFFFFFFFF;	/// The cells are not connected
+
+		Landmarks();
+
+		void build(const Grid& labyrinth, size_t count, Position start, ThreadPool* threadPool = nullptr);	/// Choose count landmarks in the part of the labyrinth connected to start
+		void repair(const Grid& labyrinth, Position changed);	/// A cell became a wall or free: repair the distances of every landmark
+		void clear();
+
+		uint32_t lowerBound(size_t from, size_t to) const;	/// Lower bound of the distance between two Grid indices (none if they are not connected)
+		uint32_t lowerBound(Position from, Position to) const;	/// Checked version
+
+		bool isEmpty() const { return m_fields.empty(); }
+		size_t count() const { return m_fields.size(); }
+		Position position(size_t landmark) const { return m_positions[landmark]; }
+		size_t memoryBytes(size_t landmark) const { return m_fields[landmark].memoryBytes(); }	/// Memory of one landmark's distances
+		size_t memoryBytes() const;
+
+	private:
+		std::vector<DistanceField> m_fields;	/// Distances from each landmark
+		std::vector<Position> m_positions;
+	};
+}
@@ -0,0 +1,77 @@
+#include "SearchArena.h"
+
+#include <algorithm>
+
+using namespace Labyrinth;
+
+namespace {
+	/**
+	* Open order
+	*
+	*	Heap order: lowest estimate first, then the highest cost (closest to the goal)
+	*/
+	inline bool after(const SearchArena::OpenNode& a, const SearchArena::OpenNode& b) {
+		return a.estimate > b.estimate || (a.estimate == b.estimate && a.cost < b.cost);
+	}
+}
+
+SearchArena::SearchArena() :
+	m_generation(0),
+	m_expandedCount(0) {
+}
+
+/**
+* Reset
+*
+*	Constant time, except when the grid is larger than every previous one
+*	or once every 4 billion queries (the stamps are cleared when the generation wraps)
+*/
+void SearchArena::reset(size_t cellCount) {
+	if (m_cells.size() < cellCount) {
+		CellState unseen;
+		unseen.seen = unseen.closed = 0;
+		unseen.cost = unseen.parent = 0;
+		m_cells.resize(cellCount, unseen);
+	}
+	m_open.clear();
+	m_expandedCount = 0;
+	if (++m_generation == 0) {
+		for (CellState& cell : m_cells)
+			cell.seen = cell.closed = 0;
+		m_generation = 1;
+	}
+}
+
+void SearchArena::open(size_t cell, uint32_t cost, size_t parent, uint32_t heuristic) {
+	CellState& state = m_cells[cell];
+	state.seen = m_generation;
+	state.cost = cost;
+	state.parent = (uint32_t)parent;
+	OpenNode node;
+	node.estimate = cost + heuristic;
+	node.cost = cost;
+	node.cell = (uint32_t)cell;
+	m_open.push_back(node);
+	std::push_heap(m_open.begin(), m_open.end(), after);
+}
+
+/**
+* Pop open
+*
+*	Skips the closed cells and the entries left behind by a cheaper open()
+*/
+bool SearchArena::popOpen(OpenNode& node) {
+	while (!m_open.empty()) {
+		std::pop_heap(m_open.begin(), m_open.end(), after);
+		node = m_open.back();
+		m_open.pop_back();
+		if (!isClosed(node.cell) && node.cost == m_cells[node.cell].cost)
+			return true;
+	}
+	return false;
+}
+
+SearchArena& SearchArena::local() {
+	static thread_local SearchArena arena;
+	return arena;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Labyrinth {
+	/**
+	* Search arena
+	*
+	*	The working memory of a grid search: per-cell cost, parent and closed flag, plus the
+	*	open list. The buffers only grow: a query starts by bumping a generation counter,
+	*	the cells stamped with an older generation count as unseen, so nothing is cleared
+	*	or reallocated between queries on the same grid.
+	*	Not thread safe: each thread uses its own, see local().
+	*/
+	class SearchArena {
+	public:
+		/**
+		* Open node
+		*
+		*	An entry of the open list (a binary heap), stale once the cell got a lower cost
+		*/
+		struct OpenNode {
+			uint32_t estimate;	/// Cost so far plus the heuristic
+			uint32_t cost;	/// Cost so far
+			uint32_t cell;
+		};
+
+		SearchArena();
+
+		void reset(size_t cellCount);	/// Start a query on a grid of cellCount cells
+
+		bool isSeen(size_t cell) const { return m_cells[cell].seen == m_generation; }
+		bool isClosed(size_t cell) const { return m_cells[cell].closed == m_generation; }
+		uint32_t getCost(size_t cell) const { return m_cells[cell].cost; }	/// Valid once seen
+		uint32_t getParent(size_t cell) const { return m_cells[cell].parent; }	/// Valid once seen
+
+		void open(size_t cell, uint32_t cost, size_t parent, uint32_t heuristic);	/// Record a (better) way to a cell and queue it
+		bool popOpen(OpenNode& node);	/// The open cell with the lowest estimate, false when the open list is empty
+		void close(size_t cell) { m_cells[cell].closed = m_generation; ++m_expandedCount; }
+		size_t getExpandedCount() const { return m_expandedCount; }	/// Cells closed since the last reset
+
+		size_t memoryBytes() const { return m_cells.capacity() * sizeof(CellState) + m_open.capacity() * sizeof(OpenNode); }
+
+		static SearchArena& local();	/// The arena of the calling thread
+
+	private:
+		struct CellState {
+			uint32_t seen;	/// Generation of the last query that reached the cell
+			uint32_t closed;	/// Generation of the last query that expanded the cell
+			uint32_t cost;
+			uint32_t parent;
+		};
+
+		std::vector<CellState> m_cells;
+		std::vector<OpenNode> m_open;
+		uint32_t m_generation;
+		size_t m_expandedCount;
+	};
+}
@@ -0,0 +1,256 @@
+#include "pch.h"
+#include "SimulationThread.h"
+
+#include "AI/Manual.h"
+
+#include <chrono>
+#include <direct.h>	// Directory utility
+
+using namespace Labyrinth;
+
+/**
+* Constructor
+*
+*	Loads the labyrinth, publishes a first snapshot and starts the simulation thread
+*/
+SimulationThread::SimulationThread(const std::string& labyrinthPatternFileName) :
+	m_labyrinthPatternFileName(labyrinthPatternFileName),
+	m_labyrinthEdited(false),
+	m_generatorSeed(0),
+	m_turnTicks(0),
+	m_turnFrequency(2.0),
+	m_maxTurnsPerTick(100000),
+	m_unlimitedTurns(false),
+	m_turnBudget(0.010),
+	m_budgetBatch(1),
+	m_dirty(false),
+	m_lastPublishTicks(0),
+	m_publishPeriod(DX::StepTimer::TicksPerSecond / 240),
+	m_running(true) {
+
+	loadLabyrinth();
+	publish();
+
+	m_thread = std::thread(&SimulationThread::run, this);
+}
+
+SimulationThread::~SimulationThread() {
+	m_running.store(false, std::memory_order_release);
+	m_thread.join();
+}
+
+bool SimulationThread::send(const SimulationCommand& command) {
+	return m_commands.push(command);
+}
+
+const SimulationSnapshot& SimulationThread::latest() {
+	return m_snapshots.latest();
+}
+
+
+//	######## ##     ## ########  ########    ###    ########
+//	   ##    ##     ## ##     ## ##         ## ##   ##     ##
+//	   ##    ##     ## ##     ## ##        ##   ##  ##     ##
+//	   ##    ######### ########  ######   ##     ## ##     ##
+//	   ##    ##     ## ##   ##   ##       ######### ##     ##
+//	   ##    ##     ## ##    ##  ##       ##     ## ##     ##
+//	   ##    ##     ## ##     ## ######## ##     ## ########
+
+/**
+* Run
+*
+*	The simulation thread: applies the commands, plays the turns that are due and publishes
+*	the state, at most every m_publishPeriod. Sleeps when there is nothing to do.
+*/
+void SimulationThread::run() {
+	while (m_running.load(std::memory_order_acquire)) {
+		SimulationCommand command;
+		while (m_commands.pop(command)) {
+			apply(command);
+			m_dirty = true;
+		}
+
+		int64_t turn(m_simulation.getTurnCount());
+		m_timer.Tick([&]()
+		{
+			if (m_unlimitedTurns)
+				playTurnsForBudget();
+			else
+				playTurns();
+		});
+		if (m_simulation.getTurnCount() != turn)
+			m_dirty = true;
+
+		if (m_dirty && m_timer.GetTotalTicks() - m_lastPublishTicks >= m_publishPeriod)
+			publish();
+		else if (m_simulation.getTurnCount() == turn)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void SimulationThread::apply(const SimulationCommand& command) {
+	switch (command.type) {
+	case SimulationCommand::moveManual:
+		m_simulation.getManual()->moveDirection(command.direction);
+		break;
+	case SimulationCommand::addPlayer:
+		m_simulation.addPlayer();
+		break;
+	case SimulationCommand::addGreedyPlayer:
+		m_simulation.addPlayer(greedyAgent);
+		break;
+	case SimulationCommand::addPathfinderPlayer:
+		m_simulation.addPlayer(pathfinderAgent);
+		break;
+	case SimulationCommand::removePlayer:
+		m_simulation.removePlayer(-1);
+		break;
+	case SimulationCommand::toggleCell: {
+		Position at(m_simulation.getPlayersPosition()[0]);
+		at.x += command.direction == left ? -1 : command.direction == right ? 1 : 0;
+		at.y += command.direction == up ? -1 : command.direction == down ? 1 : 0;
+		if (m_simulation.toggleCell(at))
+			m_labyrinthEdited = true;
+		break;
+	}
+	case SimulationCommand::reload:
+		loadLabyrinth();
+		break;
+	case SimulationCommand::generate:
+		generateLabyrinth(m_simulation.getLabyrinth().sizeX(), m_simulation.getLabyrinth().sizeY());
+		break;
+	case SimulationCommand::scaleTurnFrequency:
+		m_turnFrequency *= command.factor;
+		break;
+	case SimulationCommand::toggleUnlimited:
+		m_unlimitedTurns = !m_unlimitedTurns;
+		break;
+	default:
+		;
+	}
+}
+
+/**
+* Publish
+*
+*	Fills the back snapshot (its buffers are reused) and hands it to the renderer.
+*	The labyrinth is copied again only if cells were edited, at most once per publication.
+*/
+void SimulationThread::publish() {
+	if (m_labyrinthEdited) {
+		m_labyrinth = std::make_shared<Grid>(m_simulation.getLabyrinth());
+		m_labyrinthEdited = false;
+	}
+	SimulationSnapshot& snapshot = m_snapshots.back();
+	const std::vector<Position>& positions = m_simulation.getPlayersPosition();
+	snapshot.turn = m_simulation.getTurnCount();
+	snapshot.positions.assign(positions.begin(), positions.end());
+	snapshot.originPosition = m_simulation.getOriginPosition();
+	snapshot.endPosition = m_simulation.getEndPosition();
+	snapshot.labyrinth = m_labyrinth;
+	m_snapshots.publish();
+
+	m_dirty = false;
+	m_lastPublishTicks = m_timer.GetTotalTicks();
+}
+
+
+//	######## ##     ## ########  ##    ##  ######
+//	   ##    ##     ## ##     ## ###   ## ##    ##
+//	   ##    ##     ## ##     ## ####  ## ##
+//	   ##    ##     ## ########  ## ## ##  ######
+//	   ##    ##     ## ##   ##   ##  ####       ##
+//	   ##    ##     ## ##    ##  ##   ### ##    ##
+//	   ##     #######  ##     ## ##    ##  ######
+
+/**
+* Play turns
+*
+*	Fixed-step accumulator: plays every turn whose time has come since the last tick and keeps
+*	the leftover time for the next one, so the turn rate does not depend on the loop rate.
+*	Beyond m_maxTurnsPerTick, the late turns are dropped rather than delaying the commands.
+*/
+void SimulationThread::playTurns() {
+	uint64 period(DX::StepTimer::SecondsToTicks(1.0 / m_turnFrequency));
+	if (period == 0)
+		period = 1;
+	m_turnTicks += m_timer.GetElapsedTicks();
+	uint64 turns(m_turnTicks / period);
+	if (turns > m_maxTurnsPerTick) {
+		turns = m_maxTurnsPerTick;
+		m_turnTicks = 0;
+	}
+	else
+		m_turnTicks -= turns * period;
+	if (turns > 0)
+		m_simulation.step((int64_t)turns);
+}
+
+/**
+* Play turns for budget
+*
+*	Unlimited mode: plays turns back to back for m_turnBudget seconds, then lets the commands in.
+*	The turns are played by batches so the clock is only read a few times per tick.
+*/
+void SimulationThread::playTurnsForBudget() {
+	m_turnTicks = 0;
+	auto start = std::chrono::steady_clock::now();
+	double elapsed(0.0);
+	while (elapsed < m_turnBudget) {
+		m_simulation.step(m_budgetBatch);
+		double now(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		double batchSeconds(now - elapsed);
+		elapsed = now;
+
+		// Aim for about 16 batches per budget
+		if (batchSeconds < m_turnBudget / 32)
+			m_budgetBatch *= 2;
+		else if (batchSeconds > m_turnBudget / 8 && m_budgetBatch > 1)
+			m_budgetBatch /= 2;
+	}
+}
+
+/**
+* Load the labyrinth
+*
+*	Loads the pattern file into the simulation, or generates a labyrinth if the file is not accessible.
+*	Used at startup and on reload.
+*/
+void SimulationThread::loadLabyrinth() {
+	MazeLoadReport report = m_simulation.loadLabyrinthFromFile(m_labyrinthPatternFileName);
+
+	// Generate one if file not accessible
+	if (!report.success) {
+		OutputDebugString(L"ERROR unable to open file. folder is:\n\t");
+		char dirc[1024];
+		_getcwd(dirc, 1024);
+		std::string dirstr(dirc);
+		OutputDebugString(std::wstring(dirstr.begin(), dirstr.end()).c_str());
+		generateLabyrinth(41, 41);
+		return;
+	}
+	labyrinthLoaded(report, "loaded");
+}
+
+/**
+* Generate a labyrinth
+*
+*	Each generation uses the next seed, the algorithms take turns
+*/
+void SimulationThread::generateLabyrinth(int sizeX, int sizeY) {
+	MazeGenerator generator((MazeGenerator::Algorithm)(m_generatorSeed % 3), m_generatorSeed);
+	++m_generatorSeed;
+	labyrinthLoaded(m_simulation.generateLabyrinth(generator, sizeX, sizeY), "generated");
+}
+
+void SimulationThread::labyrinthLoaded(const MazeLoadReport& report, const char* action) {
+	m_labyrinth = std::make_shared<Grid>(m_simulation.getLabyrinth());
+	m_labyrinthEdited = false;
+
+	std::string message("\nLabyrinth " + std::to_string(m_simulation.getLabyrinth().sizeX()) + "x" + std::to_string(m_simulation.getLabyrinth().sizeY())
+		+ " " + action + ": " + std::to_string(report.bytes) + " bytes in " + std::to_string(report.seconds * 1000.0)
+		+ " ms (" + std::to_string(report.megabytesPerSecond()) + " MB/s)\n");
+	if (!m_simulation.isSolvable())
+		message += "WARNING the end cannot be reached from the origin (" + std::to_string(m_simulation.getComponents().count()) + " regions)\n";
+	OutputDebugString(std::wstring(message.begin(), message.end()).c_str());
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "..\Common\StepTimer.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "utils.h"
+#include "Engine/Simulation.h"
+#include "Engine/SpscQueue.h"
+#include "Engine/TripleBuffer.h"
+
+namespace Labyrinth {
+
+	/**
+	* Simulation snapshot
+	*
+	*	What the renderer needs of a simulation state, not modified once published
+	*/
+	struct SimulationSnapshot {
+		SimulationSnapshot() : turn(0) {};
+
+		int64_t turn;	/// The turn number
+		std::vector<Position> positions;	/// The position of every player
+		Position originPosition;
+		Position endPosition;
+		std::shared_ptr<const Grid> labyrinth;	/// Shared by the snapshots until the labyrinth changes (nullptr before the first load)
+	};
+
+	/**
+	* Simulation command
+	*
+	*	A request of the UI thread, applied by the simulation thread between two turns
+	*/
+	struct SimulationCommand {
+		typedef enum Type_t {
+			moveManual,	/// Schedule a move of the keyboard player
+			addPlayer,
+			addGreedyPlayer,	/// Add a player that follows the shortest path
+			addPathfinderPlayer,	/// Add a player that plans its path with A*
+			removePlayer,	/// Remove the last added player
+			toggleCell,	/// Turn the cell next to the keyboard player into a wall or a free cell
+			reload,	/// Load the labyrinth file again
+			generate,	/// Replace the labyrinth with a new generated one of the same size
+			scaleTurnFrequency,	/// Multiply the turn frequency
+			toggleUnlimited	/// Switch the unlimited mode on or off
+		} Type;
+
+		SimulationCommand(Type type = moveManual, Directions direction = none, double factor = 1.0) : type(type), direction(direction), factor(factor) {};
+
+		Type type;
+		Directions direction;	/// For moveManual and toggleCell
+		double factor;	/// For scaleTurnFrequency
+	};
+
+	/**
+	* Simulation thread
+	*
+	*	Runs a Simulation on its own thread, so slow turns and slow frames do not hold each other.
+	*	The UI thread sends commands through an SPSC queue and reads the snapshots published
+	*	through a triple buffer: neither thread ever waits for the other.
+	*/
+	class SimulationThread {
+	public:
+		SimulationThread(const std::string& labyrinthPatternFileName);	/// Loads the labyrinth and starts the thread
+		~SimulationThread();	/// Stops the thread
+		SimulationThread(const SimulationThread&) = delete;
+		SimulationThread& operator=(const SimulationThread&) = delete;
+
+		bool send(const SimulationCommand& command);	/// UI thread: queue a command, false if the queue is full
+		const SimulationSnapshot& latest();	/// UI thread: the latest published state, valid until the next call
+
+	private:
+		void run();	/// Thread loop: apply the commands, play the turns, publish
+		void apply(const SimulationCommand& command);
+		void loadLabyrinth();	/// Load the pattern file (or generate a labyrinth) into the simulation
+		void generateLabyrinth(int sizeX, int sizeY);	/// Generate a new labyrinth with the next seed
+		void labyrinthLoaded(const MazeLoadReport& report, const char* action);	/// Share the new labyrinth with the snapshots and log the load
+		void playTurns();	/// Play the turns due since the last tick
+		void playTurnsForBudget();	/// Play as many turns as fit in the CPU budget of a tick
+		void publish();	/// Copy the state into the back snapshot and publish it
+
+		// Game state and turn logic, only touched by the simulation thread
+		Simulation m_simulation;
+		std::string m_labyrinthPatternFileName;	/// The default filename to load
+		std::shared_ptr<const Grid> m_labyrinth;	/// Copy of the labyrinth given to the snapshots
+		bool m_labyrinthEdited;	/// Cells changed since m_labyrinth was copied
+		uint64_t m_generatorSeed;	/// Seed of the next generated labyrinth
+
+		// Turns
+		DX::StepTimer m_timer;
+		uint64 m_turnTicks;	/// The time since the last turn, in StepTimer ticks (leftover kept between ticks)
+		double m_turnFrequency;	/// The frequency at which the turns elapse
+		uint64 m_maxTurnsPerTick;	/// Late turns beyond this are dropped instead of delaying the commands
+		bool m_unlimitedTurns;	/// Play turns for m_turnBudget seconds per tick instead of following m_turnFrequency
+		double m_turnBudget;	/// CPU time per tick given to the turns in unlimited mode
+		int64_t m_budgetBatch;	/// Turns played between two clock reads in unlimited mode, adapted to the speed
+
+		// Publication
+		bool m_dirty;	/// The state changed since the last snapshot
+		uint64 m_lastPublishTicks;	/// StepTimer total ticks of the last snapshot
+		uint64 m_publishPeriod;	/// Minimum time between two snapshots
+
+		// Communication with the UI thread
+		SpscQueue<SimulationCommand, 256> m_commands;
+		TripleBuffer<SimulationSnapshot> m_snapshots;
+		std::atomic<bool> m_running;
+		std::thread m_thread;
+	};
+}
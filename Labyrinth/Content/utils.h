@@ -15,6 +15,33 @@ namespace Labyrinth {
 		right
 	} Directions;
 
+	/**
+	* Surroundings
+	*
+	*	The 4 neighbours of a cell packed in 4 bits, one per direction:
+	*	bit 0 up, bit 1 down, bit 2 left, bit 3 right. A bit is set when the neighbour is free.
+	*/
+	class Surroundings {
+	public:
+		Surroundings(const unsigned char& open = 0) : open(open) {};
+		static unsigned char bit(Directions dir) { return dir == none ? 0 : (unsigned char)(1 << (dir - 1)); };
+		bool isOpen(Directions dir) const { return (open & bit(dir)) != 0; };
+		int count() const {	/// Number of free neighbours
+			static const unsigned char counts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+			return counts[open & 15];
+		};
+		Directions nth(int n) const {	/// The n-th free direction (0 based, table lookup), none if there is not enough
+			static const unsigned char directions[16][4] = {
+				{ 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 2, 0, 0, 0 }, { 1, 2, 0, 0 },
+				{ 3, 0, 0, 0 }, { 1, 3, 0, 0 }, { 2, 3, 0, 0 }, { 1, 2, 3, 0 },
+				{ 4, 0, 0, 0 }, { 1, 4, 0, 0 }, { 2, 4, 0, 0 }, { 1, 2, 4, 0 },
+				{ 3, 4, 0, 0 }, { 1, 3, 4, 0 }, { 2, 3, 4, 0 }, { 1, 2, 3, 4 } };
+			return (Directions)directions[open & 15][n & 3];
+		};
+
+		unsigned char open;
+	};
+
 	typedef enum Cell_t {
 		empty,
 		wall
@@ -28,7 +55,8 @@ namespace Labyrinth {
 	class Position {
 	public:
 		Position(const int& x = 0, const int& y = 0) : x(x), y(y) {};
-		bool operator==(const Position& p) { return (p.x == x) && (p.y == y); };
+		bool operator==(const Position& p) const { return (p.x == x) && (p.y == y); };
+		bool operator!=(const Position& p) const { return !(*this == p); };
 
 		int x;
 		int y;
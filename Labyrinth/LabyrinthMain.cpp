@@ -2,8 +2,6 @@
 #include "LabyrinthMain.h"
 #include "Common\DirectXHelper.h"
 
-#include "Content/AI/Manual.h"
-
 using namespace Labyrinth;
 using namespace Windows::Foundation;
 using namespace Windows::System::Threading;
@@ -11,7 +9,8 @@ using namespace Concurrency;
 
 // Loads and initializes application assets when the application is loaded.
 LabyrinthMain::LabyrinthMain(const std::shared_ptr<DX::DeviceResources>& deviceResources) :
-	m_deviceResources(deviceResources)
+	m_deviceResources(deviceResources),
+	m_simulationThread(new SimulationThread("LabyrinthPattern.txt"))
 {
 	// Register to be notified if the Device is lost or recreated
 	m_deviceResources->RegisterDeviceNotify(this);
@@ -39,7 +38,7 @@ void LabyrinthMain::Update()
 	// Update scene objects.
 	m_timer.Tick([&]()
 	{
-		m_labyrinthSceneRenderer->update(m_timer);
+		// The turns are played by the simulation thread
 		m_fpsTextRenderer->Update(m_timer);
 	});
 }
@@ -69,7 +68,7 @@ bool LabyrinthMain::Render()
 	context->ClearDepthStencilView(m_deviceResources->GetDepthStencilView(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
 	// Render the scene objects.
-	m_labyrinthSceneRenderer->render();
+	m_labyrinthSceneRenderer->render(m_simulationThread->latest());
 	m_fpsTextRenderer->Render();
 
 	return true;
@@ -78,27 +77,44 @@ bool LabyrinthMain::Render()
 /**
 * keyPressed event
 *
-*	Called when a keypress event is captured by the application
+*	Called when a keypress event is captured by the application.
+*	The keys are forwarded to the simulation thread.
 */
 void LabyrinthMain::keyPressed(Windows::UI::Core::KeyEventArgs^ args) {
 	if (args->VirtualKey == Windows::System::VirtualKey::Up)
-		m_labyrinthSceneRenderer->getManual()->moveDirection(up);
+		m_simulationThread->send(SimulationCommand(SimulationCommand::moveManual, up));
 	if (args->VirtualKey == Windows::System::VirtualKey::Down)
-		m_labyrinthSceneRenderer->getManual()->moveDirection(down);
+		m_simulationThread->send(SimulationCommand(SimulationCommand::moveManual, down));
 	if (args->VirtualKey == Windows::System::VirtualKey::Left)
-		m_labyrinthSceneRenderer->getManual()->moveDirection(left);
+		m_simulationThread->send(SimulationCommand(SimulationCommand::moveManual, left));
 	if (args->VirtualKey == Windows::System::VirtualKey::Right)
-		m_labyrinthSceneRenderer->getManual()->moveDirection(right);
+		m_simulationThread->send(SimulationCommand(SimulationCommand::moveManual, right));
+	if (args->VirtualKey == Windows::System::VirtualKey::W)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::toggleCell, up));
+	if (args->VirtualKey == Windows::System::VirtualKey::S)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::toggleCell, down));
+	if (args->VirtualKey == Windows::System::VirtualKey::A)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::toggleCell, left));
+	if (args->VirtualKey == Windows::System::VirtualKey::D)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::toggleCell, right));
 	if (args->VirtualKey == Windows::System::VirtualKey::F5)
-		m_labyrinthSceneRenderer->reloadFromFile();
+		m_simulationThread->send(SimulationCommand(SimulationCommand::reload));
+	if (args->VirtualKey == Windows::System::VirtualKey::N)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::generate));
 	if (args->VirtualKey == Windows::System::VirtualKey::Add)
-		m_labyrinthSceneRenderer->addPlayer();
+		m_simulationThread->send(SimulationCommand(SimulationCommand::addPlayer));
+	if (args->VirtualKey == Windows::System::VirtualKey::G)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::addGreedyPlayer));
+	if (args->VirtualKey == Windows::System::VirtualKey::P)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::addPathfinderPlayer));
 	if (args->VirtualKey == Windows::System::VirtualKey::Subtract)
-		m_labyrinthSceneRenderer->removePlayer(-1);
+		m_simulationThread->send(SimulationCommand(SimulationCommand::removePlayer));
 	if (args->VirtualKey == Windows::System::VirtualKey::Multiply)
-		m_labyrinthSceneRenderer->augmentFrequency();
+		m_simulationThread->send(SimulationCommand(SimulationCommand::scaleTurnFrequency, none, 2.0));
 	if (args->VirtualKey == Windows::System::VirtualKey::Divide)
-		m_labyrinthSceneRenderer->diminishFrequency();
+		m_simulationThread->send(SimulationCommand(SimulationCommand::scaleTurnFrequency, none, 0.5));
+	if (args->VirtualKey == Windows::System::VirtualKey::U)
+		m_simulationThread->send(SimulationCommand(SimulationCommand::toggleUnlimited));
 }
 
 // Notifies renderers that device resources need to be released.
@@ -4,6 +4,7 @@
 #include "Common\DeviceResources.h"
 #include "Content\SampleFpsTextRenderer.h"
 #include "Content/LabyrinthSceneRenderer.h"
+#include "Content/SimulationThread.h"
 
 // Renders Direct2D and 3D content on the screen.
 namespace Labyrinth
@@ -27,6 +28,9 @@ namespace Labyrinth
 		// Cached pointer to device resources.
 		std::shared_ptr<DX::DeviceResources> m_deviceResources;
 
+		// Game state and turn logic, run on their own thread
+		std::unique_ptr<SimulationThread> m_simulationThread;
+
 		// Scene renderers
 		std::unique_ptr<SampleFpsTextRenderer> m_fpsTextRenderer;
 		std::unique_ptr<LabyrinthSceneRenderer> m_labyrinthSceneRenderer;
@@ -0,0 +1,224 @@
+/**
+* Labyrinth headless
+*
+*	Runs the simulation without any display, as fast as possible.
+*	A labyrinth named <backtracker|wilson|kruskal>:<sizeX>x<sizeY> is generated from the seed instead of loaded.
+*	A labyrinth whose end cannot be reached from the origin is rejected before any turn (exit code 3).
+*	The labyrinth is the only positional argument, everything else is a named option.
+*	Given a number of episodes, plays that many independent episodes of one player instead of the
+*	turns (at most turns turns each) and prints the statistics of the turns they took to reach the end.
+*	Given a move log file, records the turns into it, then loads it back and checks that a replay
+*	gives the final positions.
+*	Given a checkpoint file, captures the simulation halfway and saves it on another thread while
+*	the turns go on, then resumes a second simulation from the file and checks it ends the same.
+*
+*	usage: LabyrinthHeadless <labyrinth file> [--turns N] [--players N] [--seed N] [--workers N] [--batch 0|1]
+*		[--agent dumb|greedy|pathfinder] [--landmarks N] [--episodes N] [--move-log file] [--checkpoint file]
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "Engine/Simulation.h"
+
+using namespace Labyrinth;
+
+namespace {
+	int usage(const char* program) {
+		fprintf(stderr, "usage: %s <labyrinth file> [--turns N] [--players N] [--seed N] [--workers N] [--batch 0|1]"
+			" [--agent dumb|greedy|pathfinder] [--landmarks N] [--episodes N] [--move-log file] [--checkpoint file]\n", program);
+		return 1;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	std::string filename;
+	long long turns(1000000);
+	long long players(1);
+	unsigned long long seed(0);
+	unsigned workers(1);
+	bool batch(true);
+	std::string typeName("dumb");
+	size_t landmarkCount(0);
+	unsigned long long episodes(0);
+	std::string moveLogName;
+	std::string checkpointName;
+	for (int i(1); i < argc; ++i) {
+		std::string option(argv[i]);
+		if (option.compare(0, 2, "--") != 0) {
+			if (!filename.empty())
+				return usage(argv[0]);
+			filename = option;
+			continue;
+		}
+		if (i + 1 >= argc)
+			return usage(argv[0]);
+		const char* value(argv[++i]);
+		if (option == "--turns")
+			turns = atoll(value);
+		else if (option == "--players")
+			players = atoll(value);
+		else if (option == "--seed")
+			seed = strtoull(value, nullptr, 10);
+		else if (option == "--workers")
+			workers = (unsigned)atoi(value);
+		else if (option == "--batch")
+			batch = atoi(value) != 0;
+		else if (option == "--agent")
+			typeName = value;
+		else if (option == "--landmarks")
+			landmarkCount = (size_t)atoi(value);
+		else if (option == "--episodes")
+			episodes = strtoull(value, nullptr, 10);
+		else if (option == "--move-log")
+			moveLogName = value;
+		else if (option == "--checkpoint")
+			checkpointName = value;
+		else
+			return usage(argv[0]);
+	}
+	if (filename.empty() || (typeName != "dumb" && typeName != "greedy" && typeName != "pathfinder"))
+		return usage(argv[0]);
+	AgentType type(typeName == "greedy" ? greedyAgent : typeName == "pathfinder" ? pathfinderAgent : dumbAgent);
+
+	Simulation simulation;
+	simulation.setWorkerCount(workers);
+	simulation.setLandmarkCount(landmarkCount);
+	MazeLoadReport report;
+	MazeGenerator::Algorithm algorithm;
+	size_t colon(filename.find(':')), times(filename.find('x', colon));
+	if (colon != std::string::npos && times != std::string::npos && MazeGenerator::parseAlgorithm(filename.substr(0, colon), algorithm)) {
+		MazeGenerator generator(algorithm, seed);
+		report = simulation.generateLabyrinth(generator, atoi(filename.c_str() + colon + 1), atoi(filename.c_str() + times + 1));
+	}
+	else
+		report = simulation.loadLabyrinthFromFile(filename);
+	if (!report.success) {
+		fprintf(stderr, "unable to load %s\n", filename.c_str());
+		return 1;
+	}
+	printf("%s: %dx%d loaded in %.3f ms (%.1f MB/s)\n", filename.c_str(), simulation.getLabyrinth().sizeX(), simulation.getLabyrinth().sizeY(),
+		report.seconds * 1000.0, report.megabytesPerSecond());
+	const ConnectedComponents& components = simulation.getComponents();
+	uint32_t originRegion(components.get(simulation.getOriginPosition()));
+	printf("regions in %.3f ms: %zu regions, the origin's has %llu cells, %llu free cells apart from it\n", simulation.getComponentsSeconds() * 1000.0,
+		components.count(), originRegion != ConnectedComponents::none ? (unsigned long long)components.size(originRegion) : 0ull,
+		(unsigned long long)components.cellsApartFrom(originRegion));
+	if (!simulation.isSolvable()) {
+		fprintf(stderr, "%s: the end cannot be reached from the origin\n", filename.c_str());
+		return 3;
+	}
+	const DistanceField& distances = simulation.getGoalDistances();
+	printf("goal distances in %.3f ms: %u-bit cells, %zu bytes, %zu reachable cells, farthest at %u\n", simulation.getGoalDistancesSeconds() * 1000.0,
+		distances.isWide() ? 32u : 16u, distances.memoryBytes(), distances.getReachableCount(), distances.getMaxDistance());
+	const JunctionGraph& junctions = simulation.getJunctions();
+	printf("junction graph in %.3f ms: %zu nodes, %zu edges, %zu bytes\n", simulation.getJunctionsSeconds() * 1000.0,
+		junctions.nodeCount(), junctions.edgeCount(), junctions.memoryBytes());
+	const HierarchicalGraph& hierarchy = simulation.getHierarchy();
+	printf("hierarchical graph in %.3f ms: %zu tiles, %zu entrances, %zu bytes\n", simulation.getHierarchySeconds() * 1000.0,
+		hierarchy.tileCount(), hierarchy.nodeCount(), hierarchy.memoryBytes());
+	const Landmarks& landmarks = simulation.getLandmarks();
+	if (!landmarks.isEmpty())
+		printf("%zu landmarks in %.3f ms: %zu bytes each\n", landmarks.count(), simulation.getLandmarksSeconds() * 1000.0, landmarks.memoryBytes(0));
+
+	if (episodes > 0) {
+		uint32_t maxTurns((uint32_t)std::min(std::max(turns, 1ll), 0xFFFFFFFFll));
+		auto start = std::chrono::steady_clock::now();
+		EpisodeStatistics statistics(simulation.runEpisodes(type, episodes, maxTurns, seed));
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%llu %s episodes in %.3f s on %u workers: %.0f episodes/s\n", episodes, typeName.c_str(), seconds, simulation.getWorkerCount(), episodes / seconds);
+		printf("turns to the end: mean %.2f, standard deviation %.2f, min %u, p50 %u, p90 %u, p99 %u, max %u\n", statistics.mean(), statistics.standardDeviation(),
+			statistics.minimum(), statistics.percentile(0.5), statistics.percentile(0.9), statistics.percentile(0.99), statistics.maximum());
+		printf("%llu episodes reached the end, %llu stopped after %u turns\n", (unsigned long long)statistics.count(), (unsigned long long)statistics.unfinished(), maxTurns);
+		return 0;
+	}
+
+	simulation.setSeed(seed);
+	simulation.setBatchExecution(batch);
+	if (players > simulation.getPlayerCount())
+		simulation.addPlayers((size_t)(players - simulation.getPlayerCount()), type);
+	MoveLog moveLog;
+	if (!moveLogName.empty())
+		simulation.setMoveLog(&moveLog);
+
+	Checkpoint checkpoint;
+	bool checkpointSaved(false);
+	double captureSeconds(0.0), saveSeconds(0.0);
+	auto start = std::chrono::steady_clock::now();
+	if (checkpointName.empty())
+		simulation.step(turns);
+	else {
+		simulation.step(turns / 2);
+		auto captureStart = std::chrono::steady_clock::now();
+		simulation.captureCheckpoint(checkpoint);
+		captureSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - captureStart).count();
+		std::thread saver([&checkpoint, &checkpointName, &checkpointSaved, &saveSeconds]() {
+			auto saveStart = std::chrono::steady_clock::now();
+			checkpointSaved = checkpoint.save(checkpointName);
+			saveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - saveStart).count();
+		});
+		simulation.step(turns - turns / 2);
+		saver.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("%lld turns with %d players in %.3f s: %.0f turns/s, %.0f agent-turns/s\n", turns, simulation.getPlayerCount(), seconds,
+		turns / seconds, (double)turns * simulation.getPlayerCount() / seconds);
+	const PhaseTimings& timings = simulation.getTotalTimings();
+	printf("%s, %u workers: decide %.3f s, commit %.3f s\n", !batch ? "per-agent calls" : RandomWalk::isVectorized() ? "AVX2 batch" : "scalar batch",
+		simulation.getWorkerCount(), timings.decideSeconds, timings.commitSeconds);
+	const EventCounters& counters = simulation.getEventCounters();
+	printf("%llu completions, turns per completion: mean %.2f, p50 %u, p99 %u; completions per turn: mean %.2f, max %u; %llu blocked moves, %llu spawns\n",
+		(unsigned long long)counters.endReached, counters.turnsPerCompletion.mean(), counters.turnsPerCompletion.percentile(0.5), counters.turnsPerCompletion.percentile(0.99),
+		counters.completionsPerTurn.mean(), counters.completionsPerTurn.maximum(), (unsigned long long)counters.blockedMoves, (unsigned long long)counters.spawns);
+
+	// Fingerprint of the final state: the same seed must give the same value
+	unsigned long long fingerprint(14695981039346656037ull);
+	for (const Position& position : simulation.getPlayersPosition())
+		fingerprint = (fingerprint ^ ((unsigned long long)(unsigned int)position.x << 32 | (unsigned int)position.y)) * 1099511628211ull;
+	printf("seed %llu, final positions fingerprint %016llx\n", seed, fingerprint);
+
+	if (!moveLogName.empty()) {
+		printf("move log: recorded in %.3f s, %zu bytes (%.2f bits per move), %zu keyframes\n", timings.recordSeconds, moveLog.memoryBytes(),
+			moveLog.moveCount() > 0 ? moveLog.memoryBytes() * 8.0 / moveLog.moveCount() : 0.0, moveLog.keyframeCount());
+		MoveLog replayLog;
+		if (!moveLog.save(moveLogName) || !replayLog.load(moveLogName)) {
+			fprintf(stderr, "unable to save and load %s\n", moveLogName.c_str());
+			return 1;
+		}
+		MoveLog::ReplayState state;
+		start = std::chrono::steady_clock::now();
+		bool replayed(replayLog.seek(replayLog.firstTurn(), state) && replayLog.advance(state, replayLog.lastTurn() - replayLog.firstTurn()));
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		replayed = replayed && state.positions == simulation.getPlayersPosition();
+		printf("replay: %lld turns in %.3f s, %.0f turns/s, %.2f GB/s of log, %s\n", (long long)(replayLog.lastTurn() - replayLog.firstTurn()), seconds,
+			(replayLog.lastTurn() - replayLog.firstTurn()) / seconds, replayLog.memoryBytes() / seconds / 1e9, replayed ? "final positions match" : "FINAL POSITIONS DIFFER");
+		start = std::chrono::steady_clock::now();
+		replayLog.seek((replayLog.firstTurn() + replayLog.lastTurn()) / 2, state);
+		printf("seek to turn %lld in %.3f ms\n", (long long)state.turn, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1000.0);
+		if (!replayed)
+			return 4;
+	}
+
+	if (!checkpointName.empty()) {
+		printf("checkpoint at turn %lld: captured in %.3f ms, %zu bytes saved in %.3f s on another thread\n", (long long)checkpoint.header().turnCount,
+			captureSeconds * 1000.0, checkpoint.memoryBytes(), saveSeconds);
+		Simulation resumed;
+		resumed.setWorkerCount(workers);
+		start = std::chrono::steady_clock::now();
+		if (!checkpointSaved || !resumed.loadCheckpoint(checkpointName)) {
+			fprintf(stderr, "unable to save and load %s\n", checkpointName.c_str());
+			return 1;
+		}
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		resumed.step(turns - turns / 2);
+		bool same(resumed.getPlayersPosition() == simulation.getPlayersPosition() && resumed.getTurnCount() == simulation.getTurnCount());
+		printf("resumed in %.3f s, %lld turns later: %s\n", seconds, turns - turns / 2, same ? "final positions match" : "FINAL POSITIONS DIFFER");
+		if (!same)
+			return 5;
+	}
+	return 0;
+}
@@ -0,0 +1,52 @@
+/**
+* Maze converter
+*
+*	Converts labyrinth patterns between the text format and the binary format.
+*	The format of the input is detected, the output uses the other one.
+*
+*	usage: MazeConverter <input> <output>
+*/
+#include <cstdio>
+#include <string>
+
+#include "Maze/Grid.h"
+#include "Maze/MazeFile.h"
+#include "Maze/MazeLoader.h"
+
+using namespace Labyrinth;
+
+int main(int argc, char* argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s <input> <output>\n", argv[0]);
+		return 1;
+	}
+	std::string input(argv[1]), output(argv[2]);
+
+	bool binaryInput(false);
+	{
+		MappedFile file;
+		if (!file.open(input)) {
+			fprintf(stderr, "unable to open %s\n", input.c_str());
+			return 1;
+		}
+		binaryInput = MazeFile::isBinary(file.data(), (size_t)file.size());
+	}
+
+	Grid grid;
+	Position origin, end;
+	MazeLoadReport report = MazeLoader::loadFile(input, grid, origin, end);
+	if (!report.success) {
+		fprintf(stderr, "unable to load %s\n", input.c_str());
+		return 1;
+	}
+	printf("%s: %dx%d, %llu bytes loaded in %.3f ms (%.1f MB/s)\n", input.c_str(), grid.sizeX(), grid.sizeY(),
+		(unsigned long long)report.bytes, report.seconds * 1000.0, report.megabytesPerSecond());
+
+	bool saved = binaryInput ? MazeFile::saveText(output, grid, origin, end) : MazeFile::saveBinary(output, grid, origin, end);
+	if (!saved) {
+		fprintf(stderr, "unable to write %s\n", output.c_str());
+		return 1;
+	}
+	printf("%s: written as %s\n", output.c_str(), binaryInput ? "text" : "binary");
+	return 0;
+}
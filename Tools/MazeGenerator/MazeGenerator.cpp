@@ -0,0 +1,44 @@
+/**
+* Maze generator
+*
+*	Generates a perfect labyrinth and streams it to a file, one row of tiles at a time.
+*	The output is a binary maze if its name ends with ".lbyr", a text pattern otherwise.
+*
+*	usage: MazeGenerator <output> <sizeX> <sizeY> [backtracker|wilson|kruskal] [seed] [workers]
+*/
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Engine/ThreadPool.h"
+#include "Maze/MazeGenerator.h"
+
+using namespace Labyrinth;
+
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		fprintf(stderr, "usage: %s <output> <sizeX> <sizeY> [backtracker|wilson|kruskal] [seed] [workers]\n", argv[0]);
+		return 1;
+	}
+	std::string output(argv[1]);
+	int sizeX(atoi(argv[2])), sizeY(atoi(argv[3]));
+	MazeGenerator::Algorithm algorithm(MazeGenerator::recursiveBacktracker);
+	if (argc > 4 && !MazeGenerator::parseAlgorithm(argv[4], algorithm)) {
+		fprintf(stderr, "unknown algorithm %s\n", argv[4]);
+		return 1;
+	}
+	unsigned long long seed(argc > 5 ? strtoull(argv[5], nullptr, 10) : 0);
+	unsigned workers(argc > 6 ? (unsigned)atoi(argv[6]) : 0);
+	bool binary(output.size() > 5 && output.compare(output.size() - 5, 5, ".lbyr") == 0);
+
+	ThreadPool threadPool(workers);
+	MazeGenerator generator(algorithm, seed);
+	MazeLoadReport report = generator.generateFile(output, sizeX, sizeY, binary, &threadPool);
+	if (!report.success) {
+		fprintf(stderr, "unable to write %s\n", output.c_str());
+		return 1;
+	}
+	printf("%s: %dx%d %s maze, %llu bytes in %.3f s (%.1f MB/s) on %u workers\n", output.c_str(), sizeX, sizeY, binary ? "binary" : "text",
+		(unsigned long long)report.bytes, report.seconds, report.megabytesPerSecond(), threadPool.getWorkerCount());
+	return 0;
+}
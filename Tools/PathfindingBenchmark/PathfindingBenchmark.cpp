@@ -0,0 +1,239 @@
+/**
+* Pathfinding benchmark
+*
+*	Times the searches of Labyrinth/Content/Pathfinding on a labyrinth file and checks
+*	that they agree. The searches start from the end cell.
+*
+*	usage: PathfindingBenchmark <labyrinth file> [repeats] [workers]
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "Engine/ThreadPool.h"
+#include "Maze/Grid.h"
+#include "Maze/MazeLoader.h"
+#include "Pathfinding/BitboardSearch.h"
+#include "Pathfinding/ConnectedComponents.h"
+#include "Pathfinding/AStar.h"
+#include "Pathfinding/DistanceField.h"
+#include "Pathfinding/HierarchicalGraph.h"
+#include "Pathfinding/JunctionGraph.h"
+#include "Pathfinding/Landmarks.h"
+
+using namespace Labyrinth;
+
+namespace {
+	/**
+	* Time
+	*
+	*	Best wall-clock time of repeats calls, in seconds
+	*/
+	template <typename F>
+	double time(int repeats, F f) {
+		double best(0.0);
+		for (int i(0); i < repeats; ++i) {
+			auto start = std::chrono::steady_clock::now();
+			f();
+			double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+			if (i == 0 || seconds < best)
+				best = seconds;
+		}
+		return best;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <labyrinth file> [repeats] [workers]\n", argv[0]);
+		return 1;
+	}
+	std::string filename(argv[1]);
+	int repeats(argc > 2 ? atoi(argv[2]) : 5);
+	if (repeats < 1)
+		repeats = 1;
+	unsigned workers(argc > 3 ? (unsigned)atoi(argv[3]) : 0);
+
+	Grid labyrinth;
+	Position origin, end;
+	MazeLoadReport report = MazeLoader::loadFile(filename, labyrinth, origin, end);
+	if (!report.success) {
+		fprintf(stderr, "unable to load %s\n", filename.c_str());
+		return 1;
+	}
+	printf("%s: %dx%d, searches from the end (%d;%d), best of %d\n", filename.c_str(), labyrinth.sizeX(), labyrinth.sizeY(), end.x, end.y, repeats);
+
+	// Distance fields
+	DistanceField queue, bitboard;
+	double queueSeconds(time(repeats, [&]() { queue.compute(labyrinth, end, DistanceField::queueSearch); }));
+	double bitboardSeconds(time(repeats, [&]() { bitboard.compute(labyrinth, end, DistanceField::bitboardSearch); }));
+	printf("distance field, queue:    %9.3f ms, %zu reachable cells, farthest at %u\n", queueSeconds * 1000.0, queue.getReachableCount(), queue.getMaxDistance());
+	printf("distance field, bitboard: %9.3f ms, %.1fx\n", bitboardSeconds * 1000.0, queueSeconds / bitboardSeconds);
+	ThreadPool threadPool(workers);
+	DistanceField parallel;
+	double parallelSeconds(time(repeats, [&]() { parallel.compute(labyrinth, end, DistanceField::queueSearch, &threadPool); }));
+	printf("distance field, queue on %u workers: %9.3f ms, %.1fx\n", threadPool.getWorkerCount(), parallelSeconds * 1000.0, queueSeconds / parallelSeconds);
+
+	// Reachability only
+	BitboardSearch search;
+	size_t reachable(0);
+	double reachSeconds(time(repeats, [&]() { reachable = search.reach(labyrinth, end); }));
+	printf("reachability, bitboard:   %9.3f ms, %.1fx\n", reachSeconds * 1000.0, queueSeconds / reachSeconds);
+
+	// Regions: the region of the end holds the cells the searches reach
+	ConnectedComponents components;
+	double componentsSeconds(time(repeats, [&]() { components.label(labyrinth); }));
+	double componentsParallelSeconds(time(repeats, [&]() { components.label(labyrinth, &threadPool); }));
+	uint32_t endRegion(components.get(end));
+	printf("regions, union-find:      %9.3f ms, %.3f ms on %u workers, %zu regions, %llu cells with the end, origin %s\n", componentsSeconds * 1000.0,
+		componentsParallelSeconds * 1000.0, threadPool.getWorkerCount(), components.count(),
+		endRegion != ConnectedComponents::none ? (unsigned long long)components.size(endRegion) : 0ull, components.connected(origin, end) ? "connected" : "cut off");
+	bool componentsSame(endRegion != ConnectedComponents::none && components.size(endRegion) == queue.getReachableCount());
+	for (size_t i(0); componentsSame && i < labyrinth.cellCount(); ++i)
+		componentsSame = (components.at(i) == endRegion) == (queue.at(i) != DistanceField::unreachable);
+
+	// Junction graph: same distances as the field, from a sample of cells
+	JunctionGraph graph;
+	double graphSeconds(time(repeats, [&]() { graph.build(labyrinth); }));
+	size_t freeCells(0);
+	for (size_t i(0); i < labyrinth.cellCount(); ++i)
+		freeCells += labyrinth.at(i) != wall;
+	printf("junction graph:           %9.3f ms, %zu nodes, %zu edges for %zu free cells (%.1fx fewer), %zu bytes\n", graphSeconds * 1000.0,
+		graph.nodeCount(), graph.edgeCount(), freeCells, (double)freeCells / (graph.nodeCount() > 0 ? graph.nodeCount() : 1), graph.memoryBytes());
+	SearchArena arena;
+	bool graphSame(true);
+	double graphQuerySeconds(0.0);
+	int queries(0);
+	for (size_t i(0); i < labyrinth.cellCount(); i += labyrinth.cellCount() / 17 + 1) {
+		Position cell(labyrinth.position(i));
+		if (!labyrinth.contains(cell))
+			continue;
+		uint32_t distance(0);
+		graphQuerySeconds += time(1, [&]() { distance = graph.distance(cell, end, arena); });
+		++queries;
+		uint32_t expected(queue.get(cell));
+		graphSame = graphSame && distance == (expected == DistanceField::unreachable ? JunctionGraph::none : expected);
+	}
+	printf("junction graph distance:  %9.3f ms per query (%d queries)\n", queries > 0 ? graphQuerySeconds * 1000.0 / queries : 0.0, queries);
+
+	// Hierarchical graph: build, queries against flat A*, tile update against a full build
+	HierarchicalGraph hierarchy;
+	double hierarchySeconds(time(repeats, [&]() { hierarchy.build(labyrinth); }));
+	double hierarchyParallelSeconds(time(repeats, [&]() { hierarchy.build(labyrinth, 32, &threadPool); }));
+	printf("hierarchical graph:       %9.3f ms, %.3f ms on %u workers, %zu tiles, %zu entrances, %zu bytes\n", hierarchySeconds * 1000.0,
+		hierarchyParallelSeconds * 1000.0, threadPool.getWorkerCount(), hierarchy.tileCount(), hierarchy.nodeCount(), hierarchy.memoryBytes());
+
+	std::vector<uint32_t> entrances, waypoints;
+	auto pathLength = [&labyrinth](Position from, const std::vector<uint32_t>& cells) {	// The cells are on straight lines
+		uint32_t length(0);
+		for (uint32_t cell : cells) {
+			Position to(labyrinth.position(cell));
+			length += (uint32_t)(std::abs(to.x - from.x) + std::abs(to.y - from.y));
+			from = to;
+		}
+		return length;
+	};
+	double flatSeconds(0.0), hierarchicalSeconds(0.0);
+	uint64_t flatLength(0), hierarchicalLength(0);
+	bool hierarchySame(true);
+	for (size_t i(0); i < labyrinth.cellCount(); i += labyrinth.cellCount() / 17 + 1) {
+		Position from(labyrinth.position(i));
+		if (!labyrinth.contains(from) || queue.get(from) == DistanceField::unreachable)
+			continue;
+		bool found(false);
+		flatSeconds += time(1, [&]() { AStar::findPath(labyrinth, from, end, waypoints, arena); });
+		flatLength += pathLength(from, waypoints);
+		hierarchicalSeconds += time(1, [&]() {
+			found = hierarchy.findPath(labyrinth, from, end, entrances, arena);
+			// Refine every step, as the pathfinders do when they reach the entrances
+			Position at(from);
+			for (uint32_t entrance : entrances) {
+				Position next(labyrinth.position(entrance));
+				AStar::findPath(labyrinth, at, next, waypoints, arena);
+				hierarchicalLength += pathLength(at, waypoints);
+				at = next;
+			}
+		});
+		hierarchySame = hierarchySame && found;
+	}
+	printf("hierarchical paths:       %9.3f ms (flat A* %.3f ms), %.3fx the shortest length\n", hierarchicalSeconds * 1000.0, flatSeconds * 1000.0,
+		flatLength > 0 ? (double)hierarchicalLength / flatLength : 1.0);
+
+	// Landmarks: ALT A* against Manhattan A* between sampled cells, cell by cell and with jump points
+	Landmarks landmarks;
+	double landmarksSeconds(time(repeats, [&]() { landmarks.build(labyrinth, 8, origin, &threadPool); }));
+	printf("landmarks:                %9.3f ms for %zu landmarks, %zu bytes each\n", landmarksSeconds * 1000.0, landmarks.count(),
+		landmarks.count() > 0 ? landmarks.memoryBytes(0) : (size_t)0);
+	bool landmarksSame(true);
+	for (int jumpPoints(0); jumpPoints < 2; ++jumpPoints) {
+		double plainSeconds(0.0), altSeconds(0.0);
+		uint64_t plainExpanded(0), altExpanded(0);
+		for (size_t i(0); i < labyrinth.cellCount(); i += labyrinth.cellCount() / 17 + 1) {
+			Position from(labyrinth.position(i)), to(labyrinth.position(labyrinth.cellCount() - 1 - i));
+			if (!labyrinth.contains(from) || !labyrinth.contains(to) || queue.get(from) == DistanceField::unreachable)
+				continue;
+			bool plainFound(false), altFound(false);
+			plainSeconds += time(1, [&]() { plainFound = AStar::findPath(labyrinth, from, to, waypoints, arena, jumpPoints != 0); });
+			plainExpanded += arena.getExpandedCount();
+			uint32_t plainLength(pathLength(from, waypoints));
+			altSeconds += time(1, [&]() { altFound = AStar::findPath(labyrinth, from, to, waypoints, arena, jumpPoints != 0, &landmarks); });
+			altExpanded += arena.getExpandedCount();
+			landmarksSame = landmarksSame && plainFound == altFound && plainLength == pathLength(from, waypoints);
+		}
+		printf("ALT A*%s %9.3f ms, %llu expanded (Manhattan %.3f ms, %llu expanded, %.1fx more)\n", jumpPoints ? " (jump points):     " : ":                   ",
+			altSeconds * 1000.0, (unsigned long long)altExpanded, plainSeconds * 1000.0, (unsigned long long)plainExpanded,
+			altExpanded > 0 ? (double)plainExpanded / altExpanded : 0.0);
+	}
+
+	// Toggle a cell in the middle: the updated tiles must match a full build
+	Grid edited(labyrinth);
+	Position middle(labyrinth.sizeX() / 2, labyrinth.sizeY() / 2);
+	edited.set(middle, edited.get(middle) == wall ? empty : wall);
+	HierarchicalGraph rebuilt;
+	rebuilt.build(edited);
+	double updateSeconds(time(1, [&]() { hierarchy.update(edited, middle); }));
+	hierarchySame = hierarchySame && rebuilt.nodeCount() == hierarchy.nodeCount();
+	for (size_t i(0); hierarchySame && i < labyrinth.cellCount(); i += labyrinth.cellCount() / 17 + 1) {
+		Position from(labyrinth.position(i));
+		if (!labyrinth.contains(from))
+			continue;
+		std::vector<uint32_t> expected;
+		bool found(rebuilt.findPath(edited, from, end, expected, arena));
+		hierarchySame = found == hierarchy.findPath(edited, from, end, entrances, arena) && expected == entrances;
+	}
+	printf("hierarchical update:      %9.3f ms, %zu tiles rebuilt\n", updateSeconds * 1000.0, hierarchy.getLastRebuiltTiles());
+
+	// Distance repair: random cell toggles repaired one by one, against a full computation
+	DistanceField repaired;
+	repaired.compute(labyrinth, end);
+	Grid toggled(labyrinth);
+	double repairSeconds(0.0);
+	uint64_t repairedCells(0), state(0x9E3779B97F4A7C15ull);
+	const int edits(100);
+	for (int i(0); i < edits; ++i) {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		Position cell((int)(state % (uint64_t)labyrinth.sizeX()), (int)((state >> 32) % (uint64_t)labyrinth.sizeY()));
+		if (cell == end)
+			continue;
+		toggled.set(cell, toggled.get(cell) == wall ? empty : wall);
+		repairSeconds += time(1, [&]() { repairedCells += repaired.repair(toggled, cell); });
+	}
+	DistanceField recomputed;
+	double recomputeSeconds(time(repeats, [&]() { recomputed.compute(toggled, end); }));
+	bool repairSame(repaired.getReachableCount() == recomputed.getReachableCount() && repaired.getMaxDistance() == recomputed.getMaxDistance());
+	for (size_t i(0); repairSame && i < labyrinth.cellCount(); ++i)
+		repairSame = repaired.at(i) == recomputed.at(i);
+	printf("distance repair:          %9.3f ms per edit, %.0f cells changed per edit (full computation %.3f ms)\n", repairSeconds * 1000.0 / edits,
+		(double)repairedCells / edits, recomputeSeconds * 1000.0);
+
+	bool same(componentsSame && repairSame && landmarksSame && hierarchySame && graphSame && queue.getReachableCount() == bitboard.getReachableCount() && queue.getMaxDistance() == bitboard.getMaxDistance()
+		&& queue.getReachableCount() == parallel.getReachableCount() && queue.getMaxDistance() == parallel.getMaxDistance()
+		&& reachable == queue.getReachableCount());
+	for (size_t i(0); same && i < labyrinth.cellCount(); ++i)
+		same = queue.at(i) == bitboard.at(i) && queue.at(i) == parallel.at(i) && search.isVisited(labyrinth.position(i)) == (queue.at(i) != DistanceField::unreachable);
+	printf("%s\n", same ? "results match" : "RESULTS DIFFER");
+	return same ? 0 : 2;
+}